@@ -0,0 +1,180 @@
+#include <chrono>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include <new>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <vector>
+
+#ifndef ARENA_H
+#define ARENA_H
+
+// Alignment of all allocations from the arena, one cache line which is also
+// enough for the widest SIMD registers
+constexpr size_t ARENA_ALIGNMENT = 64;
+constexpr size_t ARENA_BLOCK_SIZE = 64 << 20;
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/*
+ * A memory resource that hands out cache line aligned memory from large
+ * blocks mapped directly from the kernel. Deallocation does nothing, the whole
+ * arena is released at once by reset(). The blocks are kept mapped across
+ * resets, so later rounds reuse pages that have already been faulted in.
+ */
+class ArenaMemoryResource : public std::pmr::memory_resource {
+	private:
+	struct Block {
+		std::byte *start;
+		size_t size;
+	};
+
+	bool huge_pages;
+	std::vector<Block> blocks;
+	size_t current_block = 0;
+	size_t offset = 0;
+	std::mutex mutex;
+
+	size_t number_of_allocations = 0;
+	std::chrono::duration<double> allocation_time{0};
+
+	// Maps a new block, preferring explicit huge pages and falling back to
+	// transparent huge pages when none are reserved
+	Block map_block(size_t size) {
+		if (this->huge_pages) {
+			size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE *
+				   HUGE_PAGE_SIZE;
+			void *start = mmap(
+				nullptr,
+				size,
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+				-1,
+				0
+			);
+			if (start != MAP_FAILED) {
+				return Block{static_cast<std::byte *>(start), size};
+			}
+		}
+
+		void *start = mmap(
+			nullptr,
+			size,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1,
+			0
+		);
+		if (start == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+		if (this->huge_pages) {
+			madvise(start, size, MADV_HUGEPAGE);
+		}
+		return Block{static_cast<std::byte *>(start), size};
+	}
+
+	void *do_allocate(size_t bytes, size_t alignment) override {
+		auto start = std::chrono::high_resolution_clock::now();
+		std::lock_guard<std::mutex> lock(this->mutex);
+
+		if (alignment < ARENA_ALIGNMENT) {
+			alignment = ARENA_ALIGNMENT;
+		}
+
+		// Find the first block from the current one on that fits the request
+		while (this->current_block < this->blocks.size()) {
+			size_t aligned_offset =
+				(this->offset + alignment - 1) / alignment * alignment;
+			if (aligned_offset + bytes <=
+				this->blocks[this->current_block].size) {
+				this->offset = aligned_offset;
+				break;
+			}
+			++this->current_block;
+			this->offset = 0;
+		}
+
+		if (this->current_block == this->blocks.size()) {
+			// Blocks are mapped page aligned, so the start is aligned too
+			this->blocks.push_back(this->map_block(
+				bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE
+			));
+			this->offset = 0;
+		}
+
+		void *pointer = this->blocks[this->current_block].start + this->offset;
+		this->offset += bytes;
+
+		++this->number_of_allocations;
+		this->allocation_time +=
+			std::chrono::high_resolution_clock::now() - start;
+		return pointer;
+	}
+
+	void do_deallocate(void *, size_t, size_t) override {}
+
+	bool do_is_equal(const std::pmr::memory_resource &other
+	) const noexcept override {
+		return this == &other;
+	}
+
+	public:
+	ArenaMemoryResource(bool huge_pages = false) : huge_pages(huge_pages) {}
+
+	ArenaMemoryResource(const ArenaMemoryResource &) = delete;
+	ArenaMemoryResource &operator=(const ArenaMemoryResource &) = delete;
+
+	~ArenaMemoryResource() {
+		for (const auto &block : this->blocks) {
+			munmap(block.start, block.size);
+		}
+	}
+
+	// Releases everything allocated so far at once. Nothing allocated from the
+	// arena may be used afterwards.
+	void reset() {
+		std::lock_guard<std::mutex> lock(this->mutex);
+		this->current_block = 0;
+		this->offset = 0;
+		this->number_of_allocations = 0;
+		this->allocation_time = std::chrono::duration<double>(0);
+	}
+
+	// Get the number of allocations since the last reset
+	size_t get_number_of_allocations() const {
+		return this->number_of_allocations;
+	}
+
+	// Get the time spent allocating since the last reset
+	double get_allocation_time() const { return this->allocation_time.count(); }
+};
+
+// Makes a memory resource the default one for as long as the guard lives, so
+// that all matrices and temporaries created meanwhile are allocated from it.
+// The default resource is global to the process, so this holds for the ones
+// created by other threads too.
+class DefaultResourceGuard {
+	private:
+	std::pmr::memory_resource *previous_resource;
+
+	public:
+	DefaultResourceGuard(std::pmr::memory_resource *resource)
+		: previous_resource(std::pmr::set_default_resource(resource)) {}
+
+	DefaultResourceGuard(const DefaultResourceGuard &) = delete;
+	DefaultResourceGuard &operator=(const DefaultResourceGuard &) = delete;
+
+	~DefaultResourceGuard() {
+		std::pmr::set_default_resource(this->previous_resource);
+	}
+};
+
+// Get the number of page faults of the process so far
+inline long get_number_of_page_faults() {
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_minflt + usage.ru_majflt;
+}
+
+#endif
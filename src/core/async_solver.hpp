@@ -0,0 +1,190 @@
+#include "matrix.hpp"
+#include "system_of_equations.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#ifndef ASYNC_SOLVER_H
+#define ASYNC_SOLVER_H
+
+// Number of threads loading and saving matrices, one reading the next job
+// ahead while the other writes the previous one
+constexpr size_t ASYNC_IO_THREADS = 2;
+
+enum class AsyncLane {
+	Compute,
+	Io,
+};
+
+/*
+ * Runs the tasks of the asynchronous API. The computations go through a
+ * single thread, so that they run one at a time on the whole shared thread
+ * pool, and the loading and saving through their own threads, so that they
+ * overlap with the computation. The threads are not workers of the pool, so
+ * the kernels they call still run in parallel.
+ *
+ * A task may wait for the result of any task submitted before it. Each lane
+ * starts its tasks in the order they were submitted, so the earliest
+ * unfinished task has always been started and waiting cannot deadlock.
+ */
+class AsyncExecutor {
+	private:
+	struct Lane {
+		std::queue<std::function<void()>> tasks;
+		std::vector<std::thread> threads;
+	};
+
+	Lane compute_lane;
+	Lane io_lane;
+	std::mutex mutex;
+	std::condition_variable task_available;
+	bool stopping = false;
+
+	Lane &get_lane(AsyncLane lane) {
+		return lane == AsyncLane::Compute ? this->compute_lane : this->io_lane;
+	}
+
+	void work(Lane &lane) {
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->task_available.wait(lock, [this, &lane]() {
+					return this->stopping || !lane.tasks.empty();
+				});
+				if (lane.tasks.empty()) {
+					return;
+				}
+				task = std::move(lane.tasks.front());
+				lane.tasks.pop();
+			}
+			task();
+		}
+	}
+
+	public:
+	static AsyncExecutor &shared() {
+		static AsyncExecutor executor(ASYNC_IO_THREADS);
+		return executor;
+	}
+
+	AsyncExecutor(size_t number_of_io_threads) {
+		this->compute_lane.threads.emplace_back(
+			&AsyncExecutor::work, this, std::ref(this->compute_lane)
+		);
+		for (size_t i = 0; i < std::max<size_t>(number_of_io_threads, 1); ++i) {
+			this->io_lane.threads.emplace_back(
+				&AsyncExecutor::work, this, std::ref(this->io_lane)
+			);
+		}
+	}
+
+	AsyncExecutor(const AsyncExecutor &) = delete;
+	AsyncExecutor &operator=(const AsyncExecutor &) = delete;
+
+	// Finishes the tasks that were already submitted
+	~AsyncExecutor() {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->task_available.notify_all();
+		for (Lane *lane : {&this->compute_lane, &this->io_lane}) {
+			for (auto &thread : lane->threads) {
+				thread.join();
+			}
+		}
+	}
+
+	template <typename Function>
+	std::shared_future<std::invoke_result_t<Function>>
+	submit(AsyncLane lane, Function function) {
+		auto task =
+			std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(
+				std::move(function)
+			);
+		std::shared_future<std::invoke_result_t<Function>> future =
+			task->get_future().share();
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->get_lane(lane).tasks.push([task]() { (*task)(); });
+		}
+		// Both lanes wait on the same condition
+		this->task_available.notify_all();
+		return future;
+	}
+};
+
+/*
+ * The asynchronous API: every operation is submitted to the shared executor
+ * right away and returns a future of its result, which can be handed to the
+ * next operation before it is ready. Chaining load, solve and save for a list
+ * of jobs pipelines them, reading the next job and writing the previous one
+ * while the current one is being solved. An exception thrown by an operation
+ * is passed on to every operation depending on it.
+ */
+template <typename T>
+std::shared_future<Matrix<T>> load_matrix_async(const std::string &path) {
+	return AsyncExecutor::shared().submit(AsyncLane::Io, [path]() {
+		return Matrix<T>::from_file(path);
+	});
+}
+
+template <typename T>
+std::shared_future<void> save_matrix_async(
+	std::shared_future<Matrix<T>> matrix,
+	const std::string &path,
+	bool binary = false
+) {
+	return AsyncExecutor::shared().submit(
+		AsyncLane::Io,
+		[matrix, path, binary]() { matrix.get().save_to_file(path, binary); }
+	);
+}
+
+template <typename T>
+std::shared_future<Matrix<T>> solve_system_of_equations_async(
+	std::shared_future<Matrix<T>> map,
+	std::shared_future<Matrix<T>> right_side,
+	bool parallel = true
+) {
+	return AsyncExecutor::shared().submit(
+		AsyncLane::Compute,
+		[map, right_side, parallel]() {
+			return solve_system_of_equations(
+				map.get(), right_side.get(), parallel
+			);
+		}
+	);
+}
+
+template <typename T>
+std::shared_future<Matrix<T>>
+get_inverse_async(std::shared_future<Matrix<T>> matrix, bool parallel = true) {
+	return AsyncExecutor::shared().submit(
+		AsyncLane::Compute,
+		[matrix, parallel]() { return matrix.get().get_inverse(parallel); }
+	);
+}
+
+template <typename T>
+std::shared_future<double> get_determinant_async(
+	std::shared_future<Matrix<T>> matrix,
+	DeterminantMethod method = DeterminantMethod::ParallelElimination
+) {
+	return AsyncExecutor::shared().submit(
+		AsyncLane::Compute,
+		[matrix, method]() { return matrix.get().get_determinant(method); }
+	);
+}
+
+#endif
@@ -0,0 +1,281 @@
+#include "matrix.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef BATCHED_SYSTEM_OF_EQUATIONS_H
+#define BATCHED_SYSTEM_OF_EQUATIONS_H
+
+// Number of systems stored side by side in a pack. Each lane of a SIMD
+// register works on a different system.
+constexpr size_t BATCH_LANES = 8;
+
+/*
+ * A pack of BATCH_LANES systems of the same size stored interleaved with the
+ * system index innermost. The element in the given row and column of the
+ * augmented matrix of every system of the pack is therefore stored in
+ * consecutive memory, so the innermost loops over the lanes vectorize without
+ * any gathers.
+ */
+template <typename T> class SystemPack {
+	private:
+	size_t size;
+	std::vector<T> data;
+	// Whether a lane found no nonzero pivot for a column
+	std::array<bool, BATCH_LANES> singular;
+
+	T *lanes_at(size_t row, size_t column) {
+		return &this->data[(row * (this->size + 1) + column) * BATCH_LANES];
+	}
+
+	// Swaps two rows of a single system of the pack starting at a column
+	void swap_rows(size_t lane, size_t row_a, size_t row_b, size_t start) {
+		for (size_t column = start; column <= this->size; ++column) {
+			std::swap(
+				this->lanes_at(row_a, column)[lane],
+				this->lanes_at(row_b, column)[lane]
+			);
+		}
+	}
+
+	// Brings the row with the highest absolute value in the column to the
+	// diagonal, independently in each lane
+	void pivot(size_t column) {
+		for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+			size_t pivot_row = column;
+			T highest_value = std::abs(this->lanes_at(column, column)[lane]);
+			for (size_t row = column + 1; row < this->size; ++row) {
+				T value = std::abs(this->lanes_at(row, column)[lane]);
+				if (value > highest_value) {
+					highest_value = value;
+					pivot_row = row;
+				}
+			}
+			if (highest_value == 0) {
+				this->singular[lane] = true;
+			}
+			if (pivot_row != column) {
+				this->swap_rows(lane, column, pivot_row, column);
+			}
+		}
+	}
+
+	public:
+	SystemPack(size_t size) : size(size), data(size * (size + 1) * BATCH_LANES) {
+		this->reset();
+	}
+
+	// Fills the pack with identity systems, so that unused lanes stay regular
+	void reset() {
+		this->singular.fill(false);
+		std::fill(this->data.begin(), this->data.end(), 0);
+		for (size_t position = 0; position < this->size; ++position) {
+			std::fill_n(this->lanes_at(position, position), BATCH_LANES, 1);
+		}
+	}
+
+	// Copies a system stored row by row into one lane of the pack
+	void load(size_t lane, const T *map, const T *right_side) {
+		for (size_t row = 0; row < this->size; ++row) {
+			for (size_t column = 0; column < this->size; ++column) {
+				this->lanes_at(row, column)[lane] =
+					map[row * this->size + column];
+			}
+			this->lanes_at(row, this->size)[lane] = right_side[row];
+		}
+	}
+
+	// Solves all systems of the pack, leaving the solution of each system in
+	// the last column of its lane. The lanes of singular systems stop being
+	// updated once they are found out and their solutions are zero.
+	void solve() {
+		std::array<T, BATCH_LANES> multiplicators;
+
+		for (size_t column = 0; column < this->size; ++column) {
+			this->pivot(column);
+
+			const T *pivot_row = this->lanes_at(column, column);
+			for (size_t row = column + 1; row < this->size; ++row) {
+				T *target_row = this->lanes_at(row, column);
+				for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+					multiplicators[lane] = this->singular[lane]
+											   ? 0
+											   : target_row[lane] /
+													 pivot_row[lane];
+				}
+
+				const size_t length = (this->size + 1 - column) * BATCH_LANES;
+				for (size_t offset = BATCH_LANES; offset < length;
+					 offset += BATCH_LANES) {
+					for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+						target_row[offset + lane] -=
+							multiplicators[lane] * pivot_row[offset + lane];
+					}
+				}
+			}
+		}
+
+		for (size_t row = this->size; row-- > 0;) {
+			T *solution = this->lanes_at(row, this->size);
+			for (size_t column = row + 1; column < this->size; ++column) {
+				const T *coefficient = this->lanes_at(row, column);
+				const T *known = this->lanes_at(column, this->size);
+				for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+					solution[lane] -= coefficient[lane] * known[lane];
+				}
+			}
+
+			const T *diagonal = this->lanes_at(row, row);
+			for (size_t lane = 0; lane < BATCH_LANES; ++lane) {
+				solution[lane] =
+					this->singular[lane] ? 0 : solution[lane] / diagonal[lane];
+			}
+		}
+	}
+
+	bool is_singular(size_t lane) const { return this->singular[lane]; }
+
+	// Copies the solution of one lane of the pack out
+	void store(size_t lane, T *solution) {
+		for (size_t row = 0; row < this->size; ++row) {
+			solution[row] = this->lanes_at(row, this->size)[lane];
+		}
+	}
+};
+
+// Solves a contiguous range of packs of the batch
+template <typename T>
+void solve_system_packs(
+	const std::vector<T> &maps,
+	const std::vector<T> &right_sides,
+	std::vector<T> &solutions,
+	std::vector<uint8_t> &singular,
+	size_t size,
+	size_t start_pack,
+	size_t end_pack
+) {
+	const size_t number_of_systems = right_sides.size() / size;
+	SystemPack<T> pack(size);
+
+	for (size_t pack_index = start_pack; pack_index < end_pack;
+		 ++pack_index) {
+		// The lanes past the end of the batch keep identity systems
+		pack.reset();
+
+		const size_t first_system = pack_index * BATCH_LANES;
+		const size_t number_of_lanes =
+			std::min(BATCH_LANES, number_of_systems - first_system);
+		for (size_t lane = 0; lane < number_of_lanes; ++lane) {
+			const size_t system = first_system + lane;
+			pack.load(
+				lane,
+				&maps[system * size * size],
+				&right_sides[system * size]
+			);
+		}
+
+		pack.solve();
+
+		for (size_t lane = 0; lane < number_of_lanes; ++lane) {
+			pack.store(lane, &solutions[(first_system + lane) * size]);
+			singular[first_system + lane] = pack.is_singular(lane);
+		}
+	}
+}
+
+// The solutions of a batch together with which of its systems are singular.
+// The flags are bytes rather than bools, so that workers can set them side by
+// side.
+template <typename T> struct BatchedSolution {
+	Matrix<T> solutions;
+	std::vector<uint8_t> singular;
+};
+
+/*
+ * Solves many independent systems of the same size. The coefficient matrices
+ * are stored one after another, each row by row, and so are the right sides.
+ * Each row of the returned matrix is the solution of one system, which is
+ * zero for the systems flagged as singular.
+ */
+template <typename T>
+BatchedSolution<T> solve_batched_systems_of_equations_with_singular_flags(
+	const std::vector<T> &maps,
+	const std::vector<T> &right_sides,
+	size_t size,
+	bool parallel = true
+) {
+	if (size == 0 || maps.size() % (size * size) != 0) {
+		throw std::runtime_error("The batch does not consist of square maps!");
+	}
+
+	const size_t number_of_systems = maps.size() / (size * size);
+	if (right_sides.size() != number_of_systems * size) {
+		throw std::runtime_error(
+			"The number of right sides does not match the number of maps!"
+		);
+	}
+
+	std::vector<T> solutions(number_of_systems * size);
+	std::vector<uint8_t> singular(number_of_systems);
+	const size_t number_of_packs =
+		(number_of_systems + BATCH_LANES - 1) / BATCH_LANES;
+
+	if (!parallel) {
+		solve_system_packs(
+			maps, right_sides, solutions, singular, size, 0, number_of_packs
+		);
+		return {
+			Matrix<T>(solutions, number_of_systems, size), std::move(singular)
+		};
+	}
+
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_threads = pool.get_number_of_threads();
+	const size_t chunk_size = number_of_packs / number_of_threads;
+
+	pool.run(number_of_threads, [&](size_t thread_index) {
+		size_t start_pack = thread_index * chunk_size;
+		// Ensure we do not exceed the number of packs
+		size_t end_pack = (thread_index == number_of_threads - 1)
+							  ? number_of_packs
+							  : start_pack + chunk_size;
+		solve_system_packs(
+			maps, right_sides, solutions, singular, size, start_pack, end_pack
+		);
+	});
+
+	return {Matrix<T>(solutions, number_of_systems, size), std::move(singular)};
+}
+
+// Solves a batch like solve_batched_systems_of_equations_with_singular_flags
+// but fails naming the first singular system, if there is any
+template <typename T>
+Matrix<T> solve_batched_systems_of_equations(
+	const std::vector<T> &maps,
+	const std::vector<T> &right_sides,
+	size_t size,
+	bool parallel = true
+) {
+	auto batched_solution =
+		solve_batched_systems_of_equations_with_singular_flags(
+			maps, right_sides, size, parallel
+		);
+	for (size_t system = 0; system < batched_solution.singular.size();
+		 ++system) {
+		if (batched_solution.singular[system]) {
+			throw std::runtime_error(
+				"System " + std::to_string(system) + " of the batch is singular!"
+			);
+		}
+	}
+	return std::move(batched_solution.solutions);
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#ifndef CONDITION_ESTIMATE_H
+#define CONDITION_ESTIMATE_H
+
+// Hager's method usually converges in two or three iterations, LAPACK stops
+// after five
+constexpr size_t CONDITION_ESTIMATE_ITERATIONS = 5;
+
+// How accurate a solution computed from an LU factorization can be expected
+// to be, without knowing the exact one
+template <typename T> struct AccuracyEstimate {
+	// Estimate of ||A||_1 * ||A^-1||_1, which is never larger than the real one
+	// and rarely more than a few times smaller
+	T condition_number;
+	// Bound on ||x - x'||_1 / ||x||_1 for every column of the solution,
+	// infinite when the matrix is too ill-conditioned for any guarantee
+	T forward_error_bound;
+};
+
+/*
+ * Solves A * x = b, or A^T * x = b if transposed, in place with the factors of
+ * P * A = L * U stored as by GEM: L with a unit diagonal below the diagonal,
+ * U on and above it, row i of P * A being row row_order[i] of A. All loops go
+ * along the rows of the factors.
+ */
+template <typename T, typename Index>
+void solve_with_factors(
+	const T *factors,
+	size_t stride,
+	const Index *row_order,
+	size_t size,
+	std::vector<T> &x,
+	bool transposed
+) {
+	std::vector<T> y(size);
+	if (!transposed) {
+		for (size_t row = 0; row < size; ++row) {
+			y[row] = x[row_order[row]];
+		}
+		for (size_t row = 0; row < size; ++row) {
+			const T *factor_row = factors + row * stride;
+			for (size_t i = 0; i < row; ++i) {
+				y[row] -= factor_row[i] * y[i];
+			}
+		}
+		for (size_t row = size; row-- > 0;) {
+			const T *factor_row = factors + row * stride;
+			for (size_t i = row + 1; i < size; ++i) {
+				y[row] -= factor_row[i] * y[i];
+			}
+			y[row] /= factor_row[row];
+		}
+		x = std::move(y);
+		return;
+	}
+
+	// U^T * z = b, going down the rows of U
+	y = x;
+	for (size_t row = 0; row < size; ++row) {
+		const T *factor_row = factors + row * stride;
+		y[row] /= factor_row[row];
+		for (size_t i = row + 1; i < size; ++i) {
+			y[i] -= factor_row[i] * y[row];
+		}
+	}
+	// L^T * w = z, going up the rows of L
+	for (size_t row = size; row-- > 0;) {
+		const T *factor_row = factors + row * stride;
+		for (size_t i = 0; i < row; ++i) {
+			y[i] -= factor_row[i] * y[row];
+		}
+	}
+	for (size_t row = 0; row < size; ++row) {
+		x[row_order[row]] = y[row];
+	}
+}
+
+/*
+ * Estimates ||A^-1||_1 from the factors of A by Hager's method as refined by
+ * Higham (the one behind LAPACK's condition estimators). It maximizes
+ * ||A^-1 * x||_1 over the unit ball by a gradient ascent that only visits its
+ * vertices, and takes an extra vector with alternating signs into account
+ * for the cases that fool the ascent. Every step takes one solve with A and
+ * one with A^T, so the cost is O(n^2) instead of the O(n^3) of the inverse.
+ */
+template <typename T, typename Index>
+T estimate_inverse_one_norm(
+	const T *factors, size_t stride, const Index *row_order, size_t size
+) {
+	auto one_norm = [](const std::vector<T> &vector) {
+		T norm = 0;
+		for (T value : vector) {
+			norm += std::abs(value);
+		}
+		return norm;
+	};
+
+	std::vector<T> x(size, T(1) / size);
+	std::vector<T> signs(size, 0);
+	T estimate = 0;
+	for (size_t iteration = 0; iteration < CONDITION_ESTIMATE_ITERATIONS;
+		 ++iteration) {
+		std::vector<T> y = x;
+		solve_with_factors(factors, stride, row_order, size, y, false);
+		const T norm = one_norm(y);
+		if (iteration > 0 && norm <= estimate) {
+			break;
+		}
+		estimate = norm;
+
+		std::vector<T> new_signs(size);
+		for (size_t i = 0; i < size; ++i) {
+			new_signs[i] = y[i] < 0 ? -1 : 1;
+		}
+		if (iteration > 0 && new_signs == signs) {
+			break;
+		}
+		signs = std::move(new_signs);
+
+		// The gradient shows which vertex to try next, unless no vertex is
+		// better than the current point
+		std::vector<T> z = signs;
+		solve_with_factors(factors, stride, row_order, size, z, true);
+		size_t best = 0;
+		T gradient_at_x = 0;
+		for (size_t i = 0; i < size; ++i) {
+			if (std::abs(z[i]) > std::abs(z[best])) {
+				best = i;
+			}
+			gradient_at_x += z[i] * x[i];
+		}
+		if (iteration > 0 && std::abs(z[best]) <= gradient_at_x) {
+			break;
+		}
+
+		std::fill(x.begin(), x.end(), 0);
+		x[best] = 1;
+	}
+
+	std::vector<T> alternating(size);
+	for (size_t i = 0; i < size; ++i) {
+		alternating[i] = (i % 2 == 0 ? 1 : -1) *
+						 (1 + (size > 1 ? T(i) / (size - 1) : 0));
+	}
+	solve_with_factors(factors, stride, row_order, size, alternating, false);
+	return std::max(estimate, 2 * one_norm(alternating) / (3 * size));
+}
+
+/*
+ * Estimates the accuracy of a solution computed from the factors of A. GEM
+ * gives the exact solution of (A + dA) * x' = b with
+ * |dA| <= gamma_3n * |L| * |U|, where gamma_m = m * u / (1 - m * u) for the
+ * unit roundoff u, so the backward error is at most
+ * eta = gamma_3n * || |L| * |U| ||_1 / ||A||_1, which is computed in O(n^2).
+ * The forward error is then at most cond * eta / (1 - cond * eta).
+ */
+template <typename T, typename Index>
+AccuracyEstimate<T> estimate_accuracy(
+	const T *factors,
+	size_t stride,
+	const Index *row_order,
+	size_t size,
+	T map_one_norm
+) {
+	constexpr T infinity = std::numeric_limits<T>::infinity();
+	if (size == 0) {
+		return {0, 0};
+	}
+	for (size_t row = 0; row < size; ++row) {
+		if (factors[row * stride + row] == 0) {
+			return {infinity, infinity};
+		}
+	}
+
+	const T condition_number =
+		map_one_norm *
+		estimate_inverse_one_norm(factors, stride, row_order, size);
+
+	// Column sums of |L| and then of |L| * |U|
+	std::vector<T> l_column_sums(size, 0);
+	for (size_t row = 0; row < size; ++row) {
+		const T *factor_row = factors + row * stride;
+		for (size_t i = 0; i < row; ++i) {
+			l_column_sums[i] += std::abs(factor_row[i]);
+		}
+		l_column_sums[row] += 1;
+	}
+	std::vector<T> product_column_sums(size, 0);
+	for (size_t row = 0; row < size; ++row) {
+		const T *factor_row = factors + row * stride;
+		for (size_t i = row; i < size; ++i) {
+			product_column_sums[i] += l_column_sums[row] * std::abs(factor_row[i]);
+		}
+	}
+	const T product_norm =
+		*std::max_element(product_column_sums.begin(), product_column_sums.end());
+
+	const T unit_roundoff = std::numeric_limits<T>::epsilon() / 2;
+	const T rounding = 3 * size * unit_roundoff;
+	if (rounding >= 1 || map_one_norm == 0) {
+		return {condition_number, infinity};
+	}
+	const T backward_error = rounding / (1 - rounding) * product_norm / map_one_norm;
+	const T amplification = condition_number * backward_error;
+	if (!(amplification < 1)) {
+		return {condition_number, infinity};
+	}
+	return {condition_number, amplification / (1 - amplification)};
+}
+
+#endif
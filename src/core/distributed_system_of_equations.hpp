@@ -0,0 +1,712 @@
+#include "distributed_transport.hpp"
+#include "matrix.hpp"
+#include "triangular_solve.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef DISTRIBUTED_SYSTEM_OF_EQUATIONS_H
+#define DISTRIBUTED_SYSTEM_OF_EQUATIONS_H
+
+// Number of rows and columns of the blocks dealt out to the processes, which
+// is also the width of the panels
+constexpr size_t DISTRIBUTED_BLOCK_SIZE = 64;
+// Exit status of a forked process that found the map singular
+constexpr int DISTRIBUTED_SINGULAR_EXIT_STATUS = 2;
+
+// Thrown by the processes that find no nonzero pivot for a column. The forked
+// ones only pass it on to the first process through their exit status.
+class DistributedSingularMatrixError : public std::runtime_error {
+	public:
+	DistributedSingularMatrixError()
+		: std::runtime_error("The matrix is singular!") {}
+};
+
+/*
+ * Block-cyclic distribution of the rows or the columns of a matrix: the
+ * indices are cut into blocks of block_size and block b belongs to process
+ * b mod number_of_processes, which stores its blocks one after another.
+ */
+struct BlockCyclicDistribution {
+	size_t size;
+	size_t block_size;
+	size_t number_of_processes;
+
+	size_t get_owner(size_t index) const {
+		return index / this->block_size % this->number_of_processes;
+	}
+
+	size_t get_local_index(size_t index) const {
+		return index / this->block_size / this->number_of_processes *
+				   this->block_size +
+			   index % this->block_size;
+	}
+
+	size_t get_global_index(size_t local_index, size_t process) const {
+		return (local_index / this->block_size * this->number_of_processes +
+				process) *
+				   this->block_size +
+			   local_index % this->block_size;
+	}
+
+	// Get the number of indices below the given one that belong to the
+	// process, which is also the local index of its first one at or after it
+	size_t count_owned(size_t end, size_t process) const {
+		const size_t full_blocks = end / this->block_size;
+		size_t count = full_blocks / this->number_of_processes * this->block_size;
+		const size_t remaining_blocks = full_blocks % this->number_of_processes;
+		if (process < remaining_blocks) {
+			count += this->block_size;
+		} else if (process == remaining_blocks) {
+			count += end % this->block_size;
+		}
+		return count;
+	}
+
+	size_t get_local_size(size_t process) const {
+		return this->count_owned(this->size, process);
+	}
+};
+
+// Where one process ended up spending its time
+struct DistributedProcessStatistics {
+	double compute_time;
+	double communication_time;
+	uint64_t bytes_sent;
+};
+
+template <typename T> struct DistributedSolution {
+	Matrix<T> solution;
+	std::vector<DistributedProcessStatistics> statistics;
+};
+
+/*
+ * The part one process takes in a distributed LU decomposition. The processes
+ * form a grid and the map, with the right side appended as extra columns, is
+ * distributed block-cyclically over its rows and columns. Each process only
+ * computes on its own blocks and everything else arrives as messages.
+ */
+template <typename T> class DistributedLuProcess {
+	private:
+	// The candidate for the pivot of a column one process found
+	struct PivotCandidate {
+		uint64_t row;
+		T value;
+	};
+
+	static constexpr uint64_t NO_ROW = std::numeric_limits<uint64_t>::max();
+
+	DistributedProcess &process;
+	size_t size;
+	size_t number_of_right_sides;
+	size_t grid_rows;
+	size_t grid_columns;
+	size_t grid_row;
+	size_t grid_column;
+	BlockCyclicDistribution rows;
+	BlockCyclicDistribution columns;
+	size_t number_of_local_rows;
+	size_t number_of_local_columns;
+	std::vector<T> values;
+
+	T &at(size_t local_row, size_t local_column) {
+		return this
+			->values[local_row * this->number_of_local_columns + local_column];
+	}
+
+	size_t get_rank(size_t grid_row, size_t grid_column) const {
+		return grid_row * this->grid_columns + grid_column;
+	}
+
+	// Picks the better of two candidates, preferring the upper row on a tie
+	// like EliminableMatrix does, so that the pivots are the same as in GEM
+	static PivotCandidate
+	choose_pivot(const PivotCandidate &first, const PivotCandidate &second) {
+		if (first.row == NO_ROW) {
+			return second;
+		}
+		if (second.row == NO_ROW || second.value < first.value ||
+			(second.value == first.value && first.row < second.row)) {
+			return first;
+		}
+		return second;
+	}
+
+	// Sends the values from the process at root_column to the rest of the
+	// grid row, which receive them into the same buffer
+	template <typename V>
+	void broadcast_in_grid_row(size_t root_column, V *buffer, size_t count) {
+		for (size_t column = 0; column < this->grid_columns; ++column) {
+			if (column == root_column) {
+				continue;
+			}
+			if (this->grid_column == root_column) {
+				this->process.send(
+					this->get_rank(this->grid_row, column), buffer, count
+				);
+			} else if (this->grid_column == column) {
+				this->process.receive(
+					this->get_rank(this->grid_row, root_column), buffer, count
+				);
+			}
+		}
+	}
+
+	// Sends the values from the process at root_row to the rest of the grid
+	// column, which receive them into the same buffer
+	template <typename V>
+	void broadcast_in_grid_column(size_t root_row, V *buffer, size_t count) {
+		for (size_t row = 0; row < this->grid_rows; ++row) {
+			if (row == root_row) {
+				continue;
+			}
+			if (this->grid_row == root_row) {
+				this->process.send(
+					this->get_rank(row, this->grid_column), buffer, count
+				);
+			} else if (this->grid_row == row) {
+				this->process.receive(
+					this->get_rank(root_row, this->grid_column), buffer, count
+				);
+			}
+		}
+	}
+
+	// Swaps two global rows in a range of local columns. Both rows are in the
+	// same grid column, so this is either local or an exchange between two
+	// processes of it.
+	void swap_rows(
+		size_t row_a, size_t row_b, size_t start_column, size_t count
+	) {
+		if (row_a == row_b || count == 0) {
+			return;
+		}
+
+		const size_t owner_a = this->rows.get_owner(row_a);
+		const size_t owner_b = this->rows.get_owner(row_b);
+		if (owner_a == owner_b) {
+			if (this->grid_row == owner_a) {
+				T *values_a = &this->at(this->rows.get_local_index(row_a), 0);
+				T *values_b = &this->at(this->rows.get_local_index(row_b), 0);
+				std::swap_ranges(
+					values_a + start_column,
+					values_a + start_column + count,
+					values_b + start_column
+				);
+			}
+		} else if (this->grid_row == owner_a || this->grid_row == owner_b) {
+			const size_t own_row = this->grid_row == owner_a ? row_a : row_b;
+			const size_t peer = this->get_rank(
+				this->grid_row == owner_a ? owner_b : owner_a, this->grid_column
+			);
+			this->process.exchange(
+				peer,
+				&this->at(this->rows.get_local_index(own_row), start_column),
+				count
+			);
+		}
+	}
+
+	// Factors the panel of the given columns with partial pivoting, which is
+	// only done by the grid column holding it. Each column takes a reduction
+	// of the pivot candidates, a row interchange and a broadcast of the pivot
+	// row within the grid column.
+	void factorize_panel(
+		size_t panel_start, size_t panel_end, std::vector<uint64_t> &pivots
+	) {
+		const size_t width = panel_end - panel_start;
+		const size_t start_column = this->columns.get_local_index(panel_start);
+		std::vector<T> pivot_row(width);
+
+		for (size_t column = panel_start; column < panel_end; ++column) {
+			const size_t offset = column - panel_start;
+			const size_t local_column = start_column + offset;
+
+			PivotCandidate candidate{NO_ROW, 0};
+			for (size_t local_row =
+					 this->rows.count_owned(column, this->grid_row);
+				 local_row < this->number_of_local_rows;
+				 ++local_row) {
+				candidate = choose_pivot(
+					candidate,
+					{this->rows.get_global_index(local_row, this->grid_row),
+					 std::abs(this->at(local_row, local_column))}
+				);
+			}
+
+			// Every process of the grid column reduces all the candidates in
+			// the same way, so they agree on the pivot without another round
+			for (size_t row = 0; row < this->grid_rows; ++row) {
+				if (row != this->grid_row) {
+					this->process.send(
+						this->get_rank(row, this->grid_column), &candidate, 1
+					);
+				}
+			}
+			for (size_t row = 0; row < this->grid_rows; ++row) {
+				if (row != this->grid_row) {
+					PivotCandidate other;
+					this->process.receive(
+						this->get_rank(row, this->grid_column), &other, 1
+					);
+					candidate = choose_pivot(candidate, other);
+				}
+			}
+			if (candidate.row == NO_ROW) {
+				throw std::runtime_error("No pivot!");
+			}
+			// The whole grid column sees the same pivot and stops here, the
+			// rest of the grid stops once the aborted transport fails them
+			if (candidate.value == 0) {
+				throw DistributedSingularMatrixError();
+			}
+			pivots[offset] = candidate.row;
+			this->swap_rows(column, candidate.row, start_column, width);
+
+			const size_t pivot_owner = this->rows.get_owner(column);
+			if (this->grid_row == pivot_owner) {
+				std::copy_n(
+					&this->at(this->rows.get_local_index(column), start_column),
+					width,
+					pivot_row.data()
+				);
+			}
+			this->broadcast_in_grid_column(
+				pivot_owner, pivot_row.data(), width
+			);
+
+			// The same operations as EliminableMatrix::eliminate_row, so the
+			// factors match the ones of GEM
+			for (size_t local_row =
+					 this->rows.count_owned(column + 1, this->grid_row);
+				 local_row < this->number_of_local_rows;
+				 ++local_row) {
+				T *row = &this->at(local_row, start_column);
+				T multiplier = row[offset] / pivot_row[offset];
+				T multiplicator = -multiplier;
+				for (size_t i = offset + 1; i < width; ++i) {
+					row[i] += multiplicator * pivot_row[i];
+				}
+				row[offset] = multiplier;
+			}
+		}
+	}
+
+	public:
+	DistributedLuProcess(
+		DistributedProcess &process,
+		size_t size,
+		size_t number_of_right_sides,
+		size_t block_size
+	)
+		: process(process), size(size),
+		  number_of_right_sides(number_of_right_sides) {
+		// The squarest grid, with no more rows than columns
+		const size_t number_of_processes = process.get_number_of_processes();
+		this->grid_rows = 1;
+		for (size_t rows = 1; rows * rows <= number_of_processes; ++rows) {
+			if (number_of_processes % rows == 0) {
+				this->grid_rows = rows;
+			}
+		}
+		this->grid_columns = number_of_processes / this->grid_rows;
+		this->grid_row = process.get_rank() / this->grid_columns;
+		this->grid_column = process.get_rank() % this->grid_columns;
+
+		this->rows = {size, block_size, this->grid_rows};
+		this->columns = {size + number_of_right_sides, block_size, this->grid_columns};
+		this->number_of_local_rows = this->rows.get_local_size(this->grid_row);
+		this->number_of_local_columns =
+			this->columns.get_local_size(this->grid_column);
+		this->values.resize(
+			this->number_of_local_rows * this->number_of_local_columns
+		);
+	}
+
+	// Hands every process its blocks of the map and the right side, which only
+	// the first process has
+	void scatter(const Matrix<T> *map, const Matrix<T> *right_side) {
+		if (this->process.get_rank() != 0) {
+			this->process.receive(0, this->values.data(), this->values.size());
+			return;
+		}
+
+		auto get_value = [&](size_t row, size_t column) {
+			return column < this->size
+					   ? map->at(row, column)
+					   : right_side->at(row, column - this->size);
+		};
+		for (size_t rank = this->process.get_number_of_processes(); rank-- > 0;) {
+			const size_t grid_row = rank / this->grid_columns;
+			const size_t grid_column = rank % this->grid_columns;
+			const size_t number_of_rows = this->rows.get_local_size(grid_row);
+			const size_t number_of_columns =
+				this->columns.get_local_size(grid_column);
+
+			std::vector<T> blocks(number_of_rows * number_of_columns);
+			for (size_t local_row = 0; local_row < number_of_rows; ++local_row) {
+				const size_t row = this->rows.get_global_index(local_row, grid_row);
+				for (size_t local_column = 0; local_column < number_of_columns;
+					 ++local_column) {
+					blocks[local_row * number_of_columns + local_column] =
+						get_value(
+							row,
+							this->columns.get_global_index(
+								local_column, grid_column
+							)
+						);
+				}
+			}
+
+			if (rank == 0) {
+				this->values = std::move(blocks);
+			} else {
+				this->process.send(rank, blocks.data(), blocks.size());
+			}
+		}
+	}
+
+	/*
+	 * Right-looking LU decomposition, one panel of block_size columns at a
+	 * time. The grid column holding the panel factors it and sends its pivots
+	 * and multipliers along the grid rows. Every process applies the
+	 * interchanges to its columns right of the panel, the grid row holding the
+	 * diagonal block computes its part of U and sends it along the grid
+	 * columns, and then every process updates its own trailing blocks. Every
+	 * value goes through the same operations in the same order as in GEM. The
+	 * interchanges are not applied to L left of the panel, as only U and the
+	 * transformed right side are used afterwards.
+	 */
+	void factorize() {
+		const size_t block_size = this->rows.block_size;
+		std::vector<uint64_t> pivots(block_size);
+		std::vector<T> l_panel;
+		std::vector<T> u_panel;
+
+		for (size_t panel_start = 0; panel_start < this->size;
+			 panel_start += block_size) {
+			const size_t panel_end = std::min(panel_start + block_size, this->size);
+			const size_t width = panel_end - panel_start;
+			const size_t panel_column = this->columns.get_owner(panel_start);
+			const size_t diagonal_row = this->rows.get_owner(panel_start);
+
+			if (this->grid_column == panel_column) {
+				this->factorize_panel(panel_start, panel_end, pivots);
+			}
+			this->broadcast_in_grid_row(panel_column, pivots.data(), width);
+
+			const size_t trailing_start =
+				this->columns.count_owned(panel_end, this->grid_column);
+			const size_t trailing_width =
+				this->number_of_local_columns - trailing_start;
+			for (size_t offset = 0; offset < width; ++offset) {
+				this->swap_rows(
+					panel_start + offset,
+					pivots[offset],
+					trailing_start,
+					trailing_width
+				);
+			}
+
+			// The multipliers of the rows from the diagonal block down
+			const size_t l_start =
+				this->rows.count_owned(panel_start, this->grid_row);
+			l_panel.resize((this->number_of_local_rows - l_start) * width);
+			if (this->grid_column == panel_column) {
+				const size_t start_column =
+					this->columns.get_local_index(panel_start);
+				for (size_t local_row = l_start;
+					 local_row < this->number_of_local_rows;
+					 ++local_row) {
+					std::copy_n(
+						&this->at(local_row, start_column),
+						width,
+						&l_panel[(local_row - l_start) * width]
+					);
+				}
+			}
+			this->broadcast_in_grid_row(
+				panel_column, l_panel.data(), l_panel.size()
+			);
+
+			// U of the diagonal block row, by forward substitution with the
+			// unit lower triangle of the diagonal block
+			u_panel.resize(width * trailing_width);
+			if (this->grid_row == diagonal_row) {
+				for (size_t k = 0; k < width; ++k) {
+					const T *source = &this->at(l_start + k, trailing_start);
+					for (size_t i = k + 1; i < width; ++i) {
+						T multiplicator = -l_panel[i * width + k];
+						T *target = &this->at(l_start + i, trailing_start);
+						for (size_t j = 0; j < trailing_width; ++j) {
+							target[j] += multiplicator * source[j];
+						}
+					}
+				}
+				for (size_t k = 0; k < width; ++k) {
+					std::copy_n(
+						&this->at(l_start + k, trailing_start),
+						trailing_width,
+						&u_panel[k * trailing_width]
+					);
+				}
+			}
+			this->broadcast_in_grid_column(
+				diagonal_row, u_panel.data(), u_panel.size()
+			);
+
+			// The trailing update of the rows below the diagonal block
+			for (size_t local_row =
+					 this->rows.count_owned(panel_end, this->grid_row);
+				 local_row < this->number_of_local_rows;
+				 ++local_row) {
+				const T *multipliers = &l_panel[(local_row - l_start) * width];
+				T *target = &this->at(local_row, trailing_start);
+				for (size_t k = 0; k < width; ++k) {
+					T multiplicator = -multipliers[k];
+					const T *source = &u_panel[k * trailing_width];
+					for (size_t j = 0; j < trailing_width; ++j) {
+						target[j] += multiplicator * source[j];
+					}
+				}
+			}
+		}
+	}
+
+	// Collects U and the transformed right side on the first process, which
+	// solves the triangular system. The other processes get an empty matrix.
+	Matrix<T> gather_solution() {
+		if (this->process.get_rank() != 0) {
+			this->process.send(0, this->values.data(), this->values.size());
+			return Matrix<T>(MatrixStorage<T>(), 0, 0);
+		}
+
+		const size_t number_of_columns = this->size + this->number_of_right_sides;
+		std::vector<T> factors(this->size * number_of_columns);
+		for (size_t rank = 0; rank < this->process.get_number_of_processes();
+			 ++rank) {
+			const size_t grid_row = rank / this->grid_columns;
+			const size_t grid_column = rank % this->grid_columns;
+			const size_t number_of_rows = this->rows.get_local_size(grid_row);
+			const size_t number_of_local_columns =
+				this->columns.get_local_size(grid_column);
+
+			std::vector<T> blocks(number_of_rows * number_of_local_columns);
+			if (rank == 0) {
+				blocks = this->values;
+			} else {
+				this->process.receive(rank, blocks.data(), blocks.size());
+			}
+			for (size_t local_row = 0; local_row < number_of_rows; ++local_row) {
+				const size_t row = this->rows.get_global_index(local_row, grid_row);
+				for (size_t local_column = 0;
+					 local_column < number_of_local_columns;
+					 ++local_column) {
+					factors
+						[row * number_of_columns +
+						 this->columns.get_global_index(local_column, grid_column)] =
+							blocks[local_row * number_of_local_columns + local_column];
+				}
+			}
+		}
+
+		const size_t number_of_right_sides = this->number_of_right_sides;
+		solve_upper_triangular(
+			factors.data(),
+			number_of_columns,
+			factors.data() + this->size,
+			number_of_columns,
+			this->size,
+			number_of_right_sides,
+			false
+		);
+
+		MatrixStorage<T> solution(this->size * number_of_right_sides);
+		for (size_t row = 0; row < this->size; ++row) {
+			std::copy_n(
+				&factors[row * number_of_columns + this->size],
+				number_of_right_sides,
+				&solution[row * number_of_right_sides]
+			);
+		}
+
+		return Matrix<T>(std::move(solution), this->size, number_of_right_sides);
+	}
+};
+
+// Runs one process of a distributed solve. Only the first process has the map
+// and the right side and gets the solution and the statistics of all.
+template <typename T>
+DistributedSolution<T> run_distributed_lu_process(
+	DistributedTransport &transport,
+	size_t rank,
+	size_t number_of_processes,
+	size_t size,
+	size_t number_of_right_sides,
+	size_t block_size,
+	const Matrix<T> *map,
+	const Matrix<T> *right_side
+) {
+	transport.connect(rank);
+	auto start = std::chrono::high_resolution_clock::now();
+
+	DistributedProcess process(transport, rank, number_of_processes);
+	DistributedLuProcess<T> lu_process(
+		process, size, number_of_right_sides, block_size
+	);
+	lu_process.scatter(map, right_side);
+	lu_process.factorize();
+	Matrix<T> solution = lu_process.gather_solution();
+
+	std::chrono::duration<double> elapsed =
+		std::chrono::high_resolution_clock::now() - start;
+	DistributedProcessStatistics statistics{
+		elapsed.count() - process.get_communication_time(),
+		process.get_communication_time(),
+		process.get_bytes_sent()
+	};
+	if (rank != 0) {
+		process.send(0, &statistics, 1);
+		return {std::move(solution), {}};
+	}
+
+	std::vector<DistributedProcessStatistics> all_statistics(number_of_processes);
+	all_statistics[0] = statistics;
+	for (size_t other = 1; other < number_of_processes; ++other) {
+		process.receive(other, &all_statistics[other], 1);
+	}
+	return {std::move(solution), std::move(all_statistics)};
+}
+
+/*
+ * Solves a system by an LU decomposition distributed over the given number of
+ * processes, which talk only through the transport, as they would on
+ * separate machines. This process becomes the first one and forks the rest.
+ * The processes compute sequentially: the shared thread pool does not survive
+ * a fork and each of them is meant to stand for one core. The solution is
+ * exactly the one of solve_system_of_equations, and a singular map is
+ * reported like it does.
+ */
+template <typename T>
+DistributedSolution<T> solve_system_of_equations_distributed(
+	const Matrix<T> &map,
+	const Matrix<T> &right_side,
+	size_t number_of_processes,
+	DistributedTransportType transport_type,
+	size_t block_size = DISTRIBUTED_BLOCK_SIZE
+) {
+	const size_t size = map.get_number_of_rows();
+	if (size != map.get_number_of_columns()) {
+		throw std::runtime_error(
+			"Cannot solve a system of equations with a non-square matrix!"
+		);
+	}
+	if (right_side.get_number_of_rows() != size) {
+		throw std::runtime_error("The matrix does not match the right side!");
+	}
+	if (number_of_processes == 0 || block_size == 0) {
+		throw std::runtime_error(
+			"The number of processes and the block size must be positive!"
+		);
+	}
+
+	auto transport =
+		make_distributed_transport(transport_type, number_of_processes);
+
+	std::vector<pid_t> children;
+	bool is_singular = false;
+	auto wait_for_children = [&children, &is_singular]() {
+		bool succeeded = true;
+		for (pid_t child : children) {
+			int status = 0;
+			while (waitpid(child, &status, 0) == -1 && errno == EINTR) {
+			}
+			const int exit_status =
+				WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+			is_singular = is_singular ||
+						  exit_status == DISTRIBUTED_SINGULAR_EXIT_STATUS;
+			succeeded = succeeded && exit_status == 0;
+		}
+		children.clear();
+		return succeeded;
+	};
+
+	for (size_t rank = 1; rank < number_of_processes; ++rank) {
+		pid_t child = fork();
+		if (child == -1) {
+			transport->abort();
+			wait_for_children();
+			throw std::runtime_error("Could not start a process!");
+		}
+		if (child == 0) {
+			try {
+				run_distributed_lu_process<T>(
+					*transport,
+					rank,
+					number_of_processes,
+					size,
+					right_side.get_number_of_columns(),
+					block_size,
+					nullptr,
+					nullptr
+				);
+			} catch (const DistributedSingularMatrixError &) {
+				transport->abort();
+				_exit(DISTRIBUTED_SINGULAR_EXIT_STATUS);
+			} catch (const std::exception &exception) {
+				std::cerr << "Process " << rank << ": " << exception.what()
+						  << std::endl;
+				transport->abort();
+				_exit(1);
+			}
+			_exit(0);
+		}
+		children.push_back(child);
+	}
+
+	std::optional<DistributedSolution<T>> solution;
+	try {
+		solution = run_distributed_lu_process<T>(
+			*transport,
+			0,
+			number_of_processes,
+			size,
+			right_side.get_number_of_columns(),
+			block_size,
+			&map,
+			&right_side
+		);
+	} catch (...) {
+		transport->abort();
+		wait_for_children();
+		// Whatever stopped this process, a singular map is the reason
+		if (is_singular) {
+			throw DistributedSingularMatrixError();
+		}
+		throw;
+	}
+
+	if (!wait_for_children()) {
+		if (is_singular) {
+			throw DistributedSingularMatrixError();
+		}
+		throw std::runtime_error("A process of the distributed solve failed!");
+	}
+	return std::move(*solution);
+}
+
+#endif
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifndef DISTRIBUTED_TRANSPORT_H
+#define DISTRIBUTED_TRANSPORT_H
+
+// Capacity of each of the ring buffers between two processes
+constexpr size_t SHARED_MEMORY_RING_SIZE = 1 << 18;
+
+enum class DistributedTransportType {
+	SharedMemory,
+	Socket,
+};
+
+/*
+ * Moves bytes between the processes of a distributed computation. It is
+ * created before the processes are forked and each of them connects with its
+ * rank afterwards. The bytes sent from one process to another arrive in the
+ * order they were sent; a send may block until the receiver made room.
+ */
+class DistributedTransport {
+	public:
+	virtual ~DistributedTransport() = default;
+
+	virtual void connect(size_t rank) = 0;
+	virtual void send(size_t destination, const void *buffer, size_t size) = 0;
+	virtual void receive(size_t source, void *buffer, size_t size) = 0;
+	// Makes every other process stop waiting for this one, which failed
+	virtual void abort() = 0;
+};
+
+/*
+ * A single-producer single-consumer ring buffer for every ordered pair of
+ * processes in memory shared by all of them. Both ends only move their own
+ * counter forward and yield the CPU while they have to wait.
+ */
+class SharedMemoryTransport : public DistributedTransport {
+	private:
+	struct Ring {
+		alignas(64) std::atomic<uint64_t> written;
+		alignas(64) std::atomic<uint64_t> read;
+	};
+
+	struct Header {
+		alignas(64) std::atomic<bool> failed;
+	};
+
+	size_t number_of_processes;
+	size_t rank = 0;
+	void *region;
+	size_t region_size;
+
+	Header *get_header() const { return static_cast<Header *>(this->region); }
+
+	Ring *get_ring(size_t source, size_t destination) const {
+		char *rings = static_cast<char *>(this->region) + sizeof(Header);
+		return reinterpret_cast<Ring *>(
+			rings + (source * this->number_of_processes + destination) *
+						(sizeof(Ring) + SHARED_MEMORY_RING_SIZE)
+		);
+	}
+
+	static char *get_ring_data(Ring *ring) {
+		return reinterpret_cast<char *>(ring) + sizeof(Ring);
+	}
+
+	void wait() const {
+		if (this->get_header()->failed.load(std::memory_order_relaxed)) {
+			throw std::runtime_error(
+				"Another process of the distributed computation failed!"
+			);
+		}
+		sched_yield();
+	}
+
+	public:
+	explicit SharedMemoryTransport(size_t number_of_processes)
+		: number_of_processes(number_of_processes),
+		  region_size(
+			  sizeof(Header) + number_of_processes * number_of_processes *
+								   (sizeof(Ring) + SHARED_MEMORY_RING_SIZE)
+		  ) {
+		this->region = mmap(
+			nullptr,
+			this->region_size,
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS,
+			-1,
+			0
+		);
+		if (this->region == MAP_FAILED) {
+			throw std::runtime_error("Could not map the shared memory!");
+		}
+
+		new (this->get_header()) Header{};
+		for (size_t source = 0; source < number_of_processes; ++source) {
+			for (size_t destination = 0; destination < number_of_processes;
+				 ++destination) {
+				new (this->get_ring(source, destination)) Ring{};
+			}
+		}
+	}
+
+	SharedMemoryTransport(const SharedMemoryTransport &) = delete;
+	SharedMemoryTransport &operator=(const SharedMemoryTransport &) = delete;
+
+	~SharedMemoryTransport() { munmap(this->region, this->region_size); }
+
+	void connect(size_t rank) override { this->rank = rank; }
+
+	void send(size_t destination, const void *buffer, size_t size) override {
+		Ring *ring = this->get_ring(this->rank, destination);
+		const char *source = static_cast<const char *>(buffer);
+		while (size > 0) {
+			const uint64_t written = ring->written.load(std::memory_order_relaxed);
+			const uint64_t free_bytes =
+				SHARED_MEMORY_RING_SIZE -
+				(written - ring->read.load(std::memory_order_acquire));
+			if (free_bytes == 0) {
+				this->wait();
+				continue;
+			}
+
+			const size_t offset = written % SHARED_MEMORY_RING_SIZE;
+			const size_t count = std::min<size_t>(
+				{size, free_bytes, SHARED_MEMORY_RING_SIZE - offset}
+			);
+			std::memcpy(get_ring_data(ring) + offset, source, count);
+			ring->written.store(written + count, std::memory_order_release);
+			source += count;
+			size -= count;
+		}
+	}
+
+	void receive(size_t source, void *buffer, size_t size) override {
+		Ring *ring = this->get_ring(source, this->rank);
+		char *target = static_cast<char *>(buffer);
+		while (size > 0) {
+			const uint64_t read = ring->read.load(std::memory_order_relaxed);
+			const uint64_t available =
+				ring->written.load(std::memory_order_acquire) - read;
+			if (available == 0) {
+				this->wait();
+				continue;
+			}
+
+			const size_t offset = read % SHARED_MEMORY_RING_SIZE;
+			const size_t count = std::min<size_t>(
+				{size, available, SHARED_MEMORY_RING_SIZE - offset}
+			);
+			std::memcpy(target, get_ring_data(ring) + offset, count);
+			ring->read.store(read + count, std::memory_order_release);
+			target += count;
+			size -= count;
+		}
+	}
+
+	void abort() override {
+		this->get_header()->failed.store(true, std::memory_order_relaxed);
+	}
+};
+
+/*
+ * A TCP connection between every pair of processes. Each process listens on
+ * its own port of the loopback interface, connects to the ones with a lower
+ * rank and accepts the ones with a higher rank, which introduce themselves by
+ * sending their rank first.
+ */
+class SocketTransport : public DistributedTransport {
+	private:
+	std::vector<int> listeners;
+	std::vector<uint16_t> ports;
+	std::vector<int> peers;
+
+	static void set_no_delay(int socket_descriptor) {
+		int enable = 1;
+		setsockopt(
+			socket_descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)
+		);
+	}
+
+	public:
+	explicit SocketTransport(size_t number_of_processes)
+		: peers(number_of_processes, -1) {
+		for (size_t rank = 0; rank < number_of_processes; ++rank) {
+			int listener = socket(AF_INET, SOCK_STREAM, 0);
+			if (listener == -1) {
+				throw std::runtime_error("Could not create a socket!");
+			}
+			this->listeners.push_back(listener);
+
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			address.sin_port = 0;
+			socklen_t address_length = sizeof(address);
+			if (bind(
+					listener,
+					reinterpret_cast<sockaddr *>(&address),
+					sizeof(address)
+				) == -1 ||
+				listen(listener, number_of_processes) == -1 ||
+				getsockname(
+					listener,
+					reinterpret_cast<sockaddr *>(&address),
+					&address_length
+				) == -1) {
+				throw std::runtime_error("Could not listen on the loopback!");
+			}
+			this->ports.push_back(ntohs(address.sin_port));
+		}
+	}
+
+	SocketTransport(const SocketTransport &) = delete;
+	SocketTransport &operator=(const SocketTransport &) = delete;
+
+	~SocketTransport() {
+		for (int listener : this->listeners) {
+			if (listener != -1) {
+				close(listener);
+			}
+		}
+		for (int peer : this->peers) {
+			if (peer != -1) {
+				close(peer);
+			}
+		}
+	}
+
+	void connect(size_t rank) override {
+		for (size_t other = 0; other < this->listeners.size(); ++other) {
+			if (other != rank) {
+				close(this->listeners[other]);
+				this->listeners[other] = -1;
+			}
+		}
+
+		for (size_t other = 0; other < rank; ++other) {
+			int peer = socket(AF_INET, SOCK_STREAM, 0);
+			sockaddr_in address{};
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			address.sin_port = htons(this->ports[other]);
+			if (peer == -1 || ::connect(
+								  peer,
+								  reinterpret_cast<sockaddr *>(&address),
+								  sizeof(address)
+							  ) == -1) {
+				throw std::runtime_error("Could not connect to another process!");
+			}
+			set_no_delay(peer);
+			this->peers[other] = peer;
+
+			const uint64_t own_rank = rank;
+			this->send(other, &own_rank, sizeof(own_rank));
+		}
+
+		for (size_t other = rank + 1; other < this->peers.size(); ++other) {
+			int peer = accept(this->listeners[rank], nullptr, nullptr);
+			if (peer == -1) {
+				throw std::runtime_error("Could not accept another process!");
+			}
+			set_no_delay(peer);
+
+			uint64_t peer_rank = 0;
+			size_t received = 0;
+			while (received < sizeof(peer_rank)) {
+				ssize_t count = recv(
+					peer,
+					reinterpret_cast<char *>(&peer_rank) + received,
+					sizeof(peer_rank) - received,
+					0
+				);
+				if (count <= 0) {
+					throw std::runtime_error("Could not accept another process!");
+				}
+				received += count;
+			}
+			if (peer_rank <= rank || peer_rank >= this->peers.size() ||
+				this->peers[peer_rank] != -1) {
+				throw std::runtime_error("An unexpected process connected!");
+			}
+			this->peers[peer_rank] = peer;
+		}
+
+		close(this->listeners[rank]);
+		this->listeners[rank] = -1;
+	}
+
+	void send(size_t destination, const void *buffer, size_t size) override {
+		const char *source = static_cast<const char *>(buffer);
+		while (size > 0) {
+			ssize_t count =
+				::send(this->peers[destination], source, size, MSG_NOSIGNAL);
+			if (count < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::runtime_error("Could not send to another process!");
+			}
+			source += count;
+			size -= count;
+		}
+	}
+
+	void receive(size_t source, void *buffer, size_t size) override {
+		char *target = static_cast<char *>(buffer);
+		while (size > 0) {
+			ssize_t count = recv(this->peers[source], target, size, 0);
+			if (count < 0 && errno == EINTR) {
+				continue;
+			}
+			if (count <= 0) {
+				throw std::runtime_error(
+					"Another process of the distributed computation failed!"
+				);
+			}
+			target += count;
+			size -= count;
+		}
+	}
+
+	void abort() override {
+		for (int peer : this->peers) {
+			if (peer != -1) {
+				shutdown(peer, SHUT_RDWR);
+			}
+		}
+	}
+};
+
+inline std::unique_ptr<DistributedTransport>
+make_distributed_transport(DistributedTransportType type, size_t number_of_processes) {
+	switch (type) {
+	case DistributedTransportType::SharedMemory:
+		return std::make_unique<SharedMemoryTransport>(number_of_processes);
+	case DistributedTransportType::Socket:
+		return std::make_unique<SocketTransport>(number_of_processes);
+	}
+	throw std::runtime_error("Unknown transport!");
+}
+
+/*
+ * The view one process has of a distributed computation: its rank and typed
+ * messages to the others, keeping track of how long it spent communicating,
+ * including the time it waited for the others.
+ */
+class DistributedProcess {
+	private:
+	DistributedTransport &transport;
+	size_t rank;
+	size_t number_of_processes;
+	double communication_time = 0;
+	size_t bytes_sent = 0;
+
+	template <typename F> void measure(F function) {
+		auto start = std::chrono::high_resolution_clock::now();
+		function();
+		std::chrono::duration<double> elapsed =
+			std::chrono::high_resolution_clock::now() - start;
+		this->communication_time += elapsed.count();
+	}
+
+	public:
+	DistributedProcess(
+		DistributedTransport &transport, size_t rank, size_t number_of_processes
+	)
+		: transport(transport), rank(rank),
+		  number_of_processes(number_of_processes) {}
+
+	size_t get_rank() const { return this->rank; }
+
+	size_t get_number_of_processes() const { return this->number_of_processes; }
+
+	double get_communication_time() const { return this->communication_time; }
+
+	size_t get_bytes_sent() const { return this->bytes_sent; }
+
+	template <typename T>
+	void send(size_t destination, const T *values, size_t count) {
+		this->measure([&]() {
+			this->transport.send(destination, values, count * sizeof(T));
+		});
+		this->bytes_sent += count * sizeof(T);
+	}
+
+	template <typename T>
+	void receive(size_t source, T *values, size_t count) {
+		this->measure([&]() {
+			this->transport.receive(source, values, count * sizeof(T));
+		});
+	}
+
+	// Swaps values with another process. The lower rank sends first, so two
+	// exchanges larger than the transport can buffer do not wait for each
+	// other.
+	template <typename T>
+	void exchange(size_t peer, T *values, size_t count) {
+		std::vector<T> received(count);
+		if (this->rank < peer) {
+			this->send(peer, values, count);
+			this->receive(peer, received.data(), count);
+		} else {
+			this->receive(peer, received.data(), count);
+			this->send(peer, values, count);
+		}
+		std::copy(received.begin(), received.end(), values);
+	}
+};
+
+#endif
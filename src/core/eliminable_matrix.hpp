@@ -1,35 +1,97 @@
+#include "condition_estimate.hpp"
 #include "matrix.hpp"
+#include "matrix_expression.hpp"
+#include "thread_pool.hpp"
+#include "triangular_solve.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <functional>
 #include <numeric>
 #include <optional>
 #include <stdexcept>
-#include <thread>
 #include <vector>
 
 #ifndef ELIMINABLE_MATRIX_H
 #define ELIMINABLE_MATRIX_H
 
 template <typename T>
-Matrix<T> solve_system_of_equations(Matrix<T> map, Matrix<T> right_side);
+Matrix<T> solve_system_of_equations(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+);
+
+template <typename T>
+EstimatedSolution<T> solve_system_of_equations_with_estimate(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+);
+
+template <typename T> class LuFactorization;
 
 template <typename T> class EliminableMatrix : public Matrix<T> {
 	friend Matrix<T>;
-	friend Matrix<T>
-	solve_system_of_equations<T>(Matrix<T> map, Matrix<T> right_side);
+	friend LuFactorization<T>;
+	friend Matrix<T> solve_system_of_equations<T>(
+		Matrix<T> map,
+		Matrix<T> right_side,
+		bool parallel,
+		BackSubstitutionMethod back_substitution_method
+	);
+	friend EstimatedSolution<T> solve_system_of_equations_with_estimate<T>(
+		Matrix<T> map,
+		Matrix<T> right_side,
+		bool parallel,
+		BackSubstitutionMethod back_substitution_method
+	);
 
 	private:
-	std::vector<size_t> row_order; // Keeps track of the row order for pivoting
+	// A candidate for the pivot: the row and the absolute value found in it
+	using PivotCandidate = std::optional<std::pair<size_t, T>>;
+
+	std::pmr::vector<size_t> row_order; // Keeps the row order for pivoting
+	int permutation_sign = 1; // Sign of the permutation in row_order
+	size_t owned_row_block_size; // Rows per block owned by a worker
 
-	// Swaps two rows in the row_order vector
+	// Swaps two rows in place and records the swap in the row_order vector
 	void swap_rows(size_t row_a_index, size_t row_b_index) {
+		if (row_a_index == row_b_index) {
+			return;
+		}
+
+		// Swapping the rows physically keeps every kernel working on
+		// contiguous rows without having to go through an indirection table
+		auto row_a = this->data.begin() + row_a_index * this->number_of_columns;
+		auto row_b = this->data.begin() + row_b_index * this->number_of_columns;
+		std::swap_ranges(row_a, row_a + this->number_of_columns, row_b);
+
 		std::swap(this->row_order[row_a_index], this->row_order[row_b_index]);
+		this->permutation_sign = -this->permutation_sign;
 	}
 
-	// Adds a multiple of one row to another row
-	void add_row_multiple(size_t source, size_t target, T multiplicator) {
-		for (size_t i = 0; i < this->number_of_columns; ++i) {
+	// Picks the better of two pivot candidates, preferring the upper row on a
+	// tie so that the choice does not depend on how the rows were split
+	static PivotCandidate
+	choose_pivot(const PivotCandidate &first, const PivotCandidate &second) {
+		if (!first.has_value()) {
+			return second;
+		}
+		if (!second.has_value() || second->second < first->second ||
+			(second->second == first->second && first->first < second->first)) {
+			return first;
+		}
+		return second;
+	}
+
+	// Adds a multiple of one row to another row from the given column on
+	void add_row_multiple(
+		size_t source, size_t target, T multiplicator, size_t start_column = 0
+	) {
+		for (size_t i = start_column; i < this->number_of_columns; ++i) {
 			this->at(target, i) += multiplicator * this->at(source, i);
 		}
 	}
@@ -41,98 +103,176 @@ template <typename T> class EliminableMatrix : public Matrix<T> {
 		}
 	}
 
-	// Eliminates a row using another row based on a specific column
+	// Eliminates a row using another row based on a specific column. The
+	// columns before it are zero in the row we eliminate by, so they are
+	// skipped. The eliminated position keeps the multiplier instead of the
+	// zero, so after GEM the part below the diagonal holds L of the LU
+	// factorization.
 	void eliminate_row(size_t row, size_t by, size_t column) {
-		this->add_row_multiple(
-			by, row, -this->at(row, column) / this->at(by, column)
-		);
+		T multiplier = this->at(row, column) / this->at(by, column);
+		this->add_row_multiple(by, row, -multiplier, column + 1);
+		this->at(row, column) = multiplier;
 	}
 
-	// Eliminates multiple rows sequentially
-	void eliminate_rows(
-		size_t by_row, size_t based_on_column, size_t start_row, size_t end_row
+	// Eliminates multiple rows sequentially. If a search column is given, each
+	// row is checked for the pivot of that column right after it has been
+	// updated, so the column does not have to be scanned a second time
+	PivotCandidate eliminate_rows(
+		size_t by_row,
+		size_t based_on_column,
+		size_t start_row,
+		size_t end_row,
+		std::optional<size_t> search_column = std::nullopt
 	) {
+		PivotCandidate candidate;
 		for (size_t row = start_row; row < end_row; ++row) {
 			this->eliminate_row(row, by_row, based_on_column);
+			if (search_column.has_value()) {
+				candidate = choose_pivot(
+					candidate,
+					std::make_pair(row, std::abs(this->at(row, *search_column)))
+				);
+			}
 		}
+		return candidate;
 	}
 
-	// Eliminates multiple rows in parallel using multiple threads
-	void eliminate_rows_in_parallel(
-		size_t by_row, size_t based_on_column, size_t start_row, size_t end_row
+	// Eliminates multiple rows in parallel on the shared thread pool. Every
+	// worker keeps eliminating the same blocks of rows from step to step.
+	PivotCandidate eliminate_rows_in_parallel(
+		size_t by_row,
+		size_t based_on_column,
+		size_t start_row,
+		size_t end_row,
+		std::optional<size_t> search_column = std::nullopt
 	) {
-		const size_t number_of_rows = end_row - start_row;
-		const size_t number_of_threads = std::thread::hardware_concurrency();
-		const size_t chunk_size = number_of_rows / number_of_threads;
-
-		std::vector<std::thread> threads;
-		threads.reserve(number_of_threads);
-
-		for (size_t thread_index = 0; thread_index < number_of_threads;
-			 ++thread_index) {
-			size_t chunk_start_row = start_row + thread_index * chunk_size;
-			// Ensure we do not exceed matrix bounds
-			size_t chunk_end_row = (thread_index == number_of_threads - 1)
-									   ? end_row
-									   : chunk_start_row + chunk_size;
-			threads.emplace_back(std::bind(
-				&EliminableMatrix<T>::eliminate_rows,
-				this,
-				by_row,
-				based_on_column,
-				chunk_start_row,
-				chunk_end_row
-			));
-		}
+		std::vector<PivotCandidate> candidates(
+			ThreadPool::shared().get_number_of_threads()
+		);
+
+		for_each_owned_row_block(
+			start_row,
+			end_row,
+			[&](size_t block_start, size_t block_end, size_t thread_index) {
+				candidates[thread_index] = choose_pivot(
+					candidates[thread_index],
+					this->eliminate_rows(
+						by_row,
+						based_on_column,
+						block_start,
+						block_end,
+						search_column
+					)
+				);
+			},
+			this->owned_row_block_size
+		);
 
-		for (auto &thread : threads) {
-			thread.join();
+		PivotCandidate candidate;
+		for (const auto &thread_candidate : candidates) {
+			candidate = choose_pivot(candidate, thread_candidate);
 		}
+		return candidate;
 	}
 
-	// Pivots the matrix to bring the highest value in the column to the
-	// diagonal
-	void pivot(size_t column) {
-		std::optional<std::pair<size_t, T>> row_with_highest_value;
+	// Finds the row with the highest absolute value in the column on or below
+	// the diagonal
+	PivotCandidate find_pivot(size_t column) const {
+		PivotCandidate candidate;
 		for (size_t row = column; row < this->number_of_rows; ++row) {
-			auto val = std::abs(this->at(row, column));
-			if (!row_with_highest_value.has_value() ||
-				val > row_with_highest_value->second) {
-				row_with_highest_value = std::make_pair(row, val);
-			}
+			candidate = choose_pivot(
+				candidate,
+				std::make_pair(row, std::abs(Matrix<T>::at(row, column)))
+			);
 		}
+		return candidate;
+	}
 
-		if (!row_with_highest_value.has_value()) {
+	// Pivots the matrix to bring the given candidate to the diagonal
+	void pivot(size_t column, const PivotCandidate &candidate) {
+		if (!candidate.has_value()) {
 			throw std::runtime_error("No pivot!");
 		}
 
-		this->swap_rows(column, row_with_highest_value->first);
+		this->swap_rows(column, candidate->first);
 	}
 
-	EliminableMatrix<T>(const Matrix<T> &matrix) : Matrix<T>(matrix) {
-		this->row_order = std::vector<size_t>(this->number_of_rows);
+	// The buffer is left untouched until the rows are copied by the workers
+	// that are going to eliminate them, so that its pages are placed on the
+	// NUMA nodes of their owners when they are first written
+	EliminableMatrix<T>(const Matrix<T> &matrix)
+		: Matrix<T>(
+			  MatrixStorage<T>(
+				  matrix.get_number_of_rows() * matrix.get_number_of_columns()
+			  ),
+			  matrix.get_number_of_rows(),
+			  matrix.get_number_of_columns()
+		  ),
+		  owned_row_block_size(
+			  get_owned_row_block_size<T>(matrix.get_number_of_columns())
+		  ) {
+		place_owned_row_blocks(
+			this->data.data(),
+			this->number_of_rows,
+			this->number_of_columns,
+			this->owned_row_block_size
+		);
+		for_each_owned_row_block(
+			0,
+			this->number_of_rows,
+			[this, &matrix](size_t start_row, size_t end_row, size_t) {
+				std::copy(
+					&matrix.at(start_row, 0),
+					&matrix.at(start_row, 0) +
+						(end_row - start_row) * this->number_of_columns,
+					&this->at(start_row, 0)
+				);
+			},
+			this->owned_row_block_size
+		);
+
+		this->row_order = std::pmr::vector<size_t>(this->number_of_rows);
 		std::iota(this->row_order.begin(), this->row_order.end(), 0);
 	}
 
 	// Performs Gaussian Elimination Method (GEM) on the matrix
 	void perform_gem(bool parallel = true) {
+		PivotCandidate candidate = this->find_pivot(0);
 		for (size_t column = 0; column < this->number_of_rows; ++column) {
-			this->pivot(column);
+			this->pivot(column, candidate);
+
+			std::optional<size_t> next_column;
+			if (column + 1 < this->number_of_rows) {
+				next_column = column + 1;
+			}
+
 			if (this->at(column, column) != 0) {
 				if (parallel) {
-					this->eliminate_rows_in_parallel(
-						column, column, column + 1, this->number_of_rows
+					candidate = this->eliminate_rows_in_parallel(
+						column,
+						column,
+						column + 1,
+						this->number_of_rows,
+						next_column
 					);
 				} else {
-					this->eliminate_rows(
-						column, column, column + 1, this->number_of_rows
+					candidate = this->eliminate_rows(
+						column,
+						column,
+						column + 1,
+						this->number_of_rows,
+						next_column
 					);
 				}
+			} else if (next_column.has_value()) {
+				candidate = this->find_pivot(*next_column);
 			}
 		}
 	}
 
-	// Performs Jordan Elimination Method (JEM) on the matrix
+	// Performs Jordan Elimination Method (JEM) on the matrix. The positions
+	// above the diagonal keep the multipliers too, so only the columns right of
+	// the square part are meaningful afterwards.
 	void perform_jem(bool parallel = true) {
 		for (size_t row = 1; row < this->number_of_rows; ++row) {
 			if (this->at(row, row) != 0) {
@@ -145,6 +285,58 @@ template <typename T> class EliminableMatrix : public Matrix<T> {
 		}
 	}
 
+	// Solves the upper triangle left by GEM for the columns right of the
+	// square part, which end up holding the solution. Unlike JEM followed by
+	// normalization, only those columns are touched, which takes O(n^2 * k)
+	// instead of O(n^3) operations for k right sides.
+	void perform_back_substitution(bool parallel = true) {
+		solve_upper_triangular(
+			this->data.data(),
+			this->number_of_columns,
+			this->data.data() + this->number_of_rows,
+			this->number_of_columns,
+			this->number_of_rows,
+			this->number_of_columns - this->number_of_rows,
+			parallel
+		);
+	}
+
+	// Solves the square part left by GEM for the columns right of it with the
+	// given method. Throws like LuFactorization::solve if there is a zero on
+	// the diagonal, instead of filling the solution with NaNs.
+	void perform_back_substitution(
+		BackSubstitutionMethod back_substitution_method, bool parallel = true
+	) {
+		for (size_t position = 0; position < this->number_of_rows;
+			 ++position) {
+			if (this->at(position, position) == 0) {
+				throw std::runtime_error("The matrix is singular!");
+			}
+		}
+
+		switch (back_substitution_method) {
+		case BackSubstitutionMethod::Triangular:
+			this->perform_back_substitution(parallel);
+			break;
+		case BackSubstitutionMethod::Jordan:
+			this->perform_jem(parallel);
+			this->normalize_rows_based_on_diagonal(parallel);
+			break;
+		}
+	}
+
+	// Estimates the accuracy of the solution from the factors left by GEM,
+	// given the 1-norm of the square part before the elimination
+	AccuracyEstimate<T> estimate_accuracy(T map_one_norm) const {
+		return ::estimate_accuracy(
+			this->data.data(),
+			this->number_of_columns,
+			this->row_order.data(),
+			this->number_of_rows,
+			map_one_norm
+		);
+	}
+
 	// Normalizes rows based on the diagonal elements
 	void normalize_rows_based_on_diagonal(bool parallel = true) {
 		if (!parallel) {
@@ -156,35 +348,18 @@ template <typename T> class EliminableMatrix : public Matrix<T> {
 			return;
 		}
 
-		const size_t number_of_threads = std::thread::hardware_concurrency();
-		const size_t chunk_size = this->number_of_rows / number_of_threads;
-
-		std::vector<std::thread> threads;
-		threads.reserve(number_of_threads);
-
-		for (size_t thread_index = 0; thread_index < number_of_threads;
-			 ++thread_index) {
-			size_t start_row = thread_index * chunk_size;
-			// Ensure we do not exceed matrix bounds
-			size_t end_row = (thread_index == number_of_threads - 1)
-								 ? this->number_of_rows
-								 : start_row + chunk_size;
-			threads.emplace_back(
-				[this](size_t start_row, size_t end_row) {
-					for (size_t row = start_row; row < end_row; ++row) {
-						if (this->at(row, row) != 0) {
-							this->multiply_row(row, 1. / this->at(row, row));
-						}
+		for_each_owned_row_block(
+			0,
+			this->number_of_rows,
+			[this](size_t start_row, size_t end_row, size_t) {
+				for (size_t row = start_row; row < end_row; ++row) {
+					if (this->at(row, row) != 0) {
+						this->multiply_row(row, 1. / this->at(row, row));
 					}
-				},
-				start_row,
-				end_row
-			);
-		}
-
-		for (auto &thread : threads) {
-			thread.join();
-		}
+				}
+			},
+			this->owned_row_block_size
+		);
 	}
 
 	T &at(size_t row, size_t column) {
@@ -0,0 +1,491 @@
+#include "lu_factorization.hpp"
+#include "matrix.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef FACTORIZATION_CACHE_H
+#define FACTORIZATION_CACHE_H
+
+constexpr uint64_t XXHASH64_PRIME_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t XXHASH64_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t XXHASH64_PRIME_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t XXHASH64_PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t XXHASH64_PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+constexpr uint64_t FACTORIZATION_FILE_MAGIC = 0x31554c4d4547; // "GEMLU1"
+constexpr uint32_t FACTORIZATION_FILE_VERSION = 1;
+// The factors start on a cache line so that they can be used in place
+constexpr size_t FACTORIZATION_FILE_ALIGNMENT = 64;
+constexpr char FACTORIZATION_FILE_EXTENSION[] = ".lu";
+
+inline uint64_t xxhash64_rotate_left(uint64_t value, int bits) {
+	return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t xxhash64_round(uint64_t accumulator, uint64_t input) {
+	accumulator += input * XXHASH64_PRIME_2;
+	return xxhash64_rotate_left(accumulator, 31) * XXHASH64_PRIME_1;
+}
+
+inline uint64_t xxhash64_merge_round(uint64_t accumulator, uint64_t value) {
+	accumulator ^= xxhash64_round(0, value);
+	return accumulator * XXHASH64_PRIME_1 + XXHASH64_PRIME_4;
+}
+
+template <typename V> V xxhash64_read(const unsigned char *input) {
+	V value;
+	std::memcpy(&value, input, sizeof(V));
+	return value;
+}
+
+/*
+ * The 64-bit variant of xxHash (https://github.com/Cyan4973/xxHash), which
+ * hashes several gigabytes per second on a single core, so hashing a matrix
+ * costs next to nothing compared to reading it. Little endian only, like the
+ * cache files themselves.
+ */
+inline uint64_t xxhash64(const void *data, size_t length, uint64_t seed = 0) {
+	const unsigned char *input = static_cast<const unsigned char *>(data);
+	const unsigned char *end = input + length;
+	uint64_t hash;
+
+	if (length >= 32) {
+		uint64_t lanes[4] = {
+			seed + XXHASH64_PRIME_1 + XXHASH64_PRIME_2,
+			seed + XXHASH64_PRIME_2,
+			seed,
+			seed - XXHASH64_PRIME_1
+		};
+		for (; input + 32 <= end; input += 32) {
+			for (size_t lane = 0; lane < 4; ++lane) {
+				lanes[lane] = xxhash64_round(
+					lanes[lane], xxhash64_read<uint64_t>(input + lane * 8)
+				);
+			}
+		}
+
+		hash = xxhash64_rotate_left(lanes[0], 1) +
+			   xxhash64_rotate_left(lanes[1], 7) +
+			   xxhash64_rotate_left(lanes[2], 12) +
+			   xxhash64_rotate_left(lanes[3], 18);
+		for (size_t lane = 0; lane < 4; ++lane) {
+			hash = xxhash64_merge_round(hash, lanes[lane]);
+		}
+	} else {
+		hash = seed + XXHASH64_PRIME_5;
+	}
+
+	hash += length;
+
+	for (; input + 8 <= end; input += 8) {
+		hash ^= xxhash64_round(0, xxhash64_read<uint64_t>(input));
+		hash = xxhash64_rotate_left(hash, 27) * XXHASH64_PRIME_1 +
+			   XXHASH64_PRIME_4;
+	}
+	if (input + 4 <= end) {
+		hash ^= uint64_t(xxhash64_read<uint32_t>(input)) * XXHASH64_PRIME_1;
+		hash = xxhash64_rotate_left(hash, 23) * XXHASH64_PRIME_2 +
+			   XXHASH64_PRIME_3;
+		input += 4;
+	}
+	for (; input < end; ++input) {
+		hash ^= *input * XXHASH64_PRIME_5;
+		hash = xxhash64_rotate_left(hash, 11) * XXHASH64_PRIME_1;
+	}
+
+	hash ^= hash >> 33;
+	hash *= XXHASH64_PRIME_2;
+	hash ^= hash >> 29;
+	hash *= XXHASH64_PRIME_3;
+	hash ^= hash >> 32;
+	return hash;
+}
+
+// Hash the size, the type and the values of a matrix
+template <typename T> uint64_t hash_matrix(const Matrix<T> &matrix) {
+	const uint64_t shape[3] = {
+		matrix.get_number_of_rows(), matrix.get_number_of_columns(), sizeof(T)
+	};
+	const uint64_t seed = xxhash64(shape, sizeof(shape));
+	if (matrix.get_number_of_rows() * matrix.get_number_of_columns() == 0) {
+		return seed;
+	}
+	return xxhash64(
+		&matrix.at(0, 0),
+		matrix.get_number_of_rows() * matrix.get_number_of_columns() *
+			sizeof(T),
+		seed
+	);
+}
+
+/*
+ * A cache file is this header followed by the factors as a row-major array
+ * of values and the row order as an array of 64-bit indices, both in the
+ * native byte order at the given offsets. It can thus be mapped and used
+ * without parsing or copying anything.
+ */
+struct FactorizationFileHeader {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t value_size;
+	uint64_t hash;
+	uint64_t size;
+	int64_t permutation_sign;
+	uint64_t factors_offset;
+	uint64_t row_order_offset;
+	uint64_t file_size;
+};
+
+// A whole file mapped read-only for as long as the object lives
+class MappedFile {
+	private:
+	void *start = MAP_FAILED;
+	size_t size = 0;
+
+	public:
+	MappedFile(const std::filesystem::path &path) {
+		int file_descriptor = open(path.c_str(), O_RDONLY);
+		if (file_descriptor == -1) {
+			throw std::runtime_error("Could not open " + path.string());
+		}
+
+		struct stat status;
+		if (fstat(file_descriptor, &status) == 0 && status.st_size > 0) {
+			this->size = status.st_size;
+			this->start = mmap(
+				nullptr, this->size, PROT_READ, MAP_SHARED, file_descriptor, 0
+			);
+		}
+		close(file_descriptor);
+
+		if (this->start == MAP_FAILED) {
+			throw std::runtime_error("Could not map " + path.string());
+		}
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	~MappedFile() { munmap(this->start, this->size); }
+
+	const char *get_data() const {
+		return static_cast<const char *>(this->start);
+	}
+
+	size_t get_size() const { return this->size; }
+};
+
+// Holds an exclusive lock on a file for as long as the object lives
+class FileLock {
+	private:
+	int file_descriptor;
+
+	public:
+	FileLock(const std::filesystem::path &path) {
+		this->file_descriptor = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+		if (this->file_descriptor == -1) {
+			throw std::runtime_error("Could not open " + path.string());
+		}
+		flock(this->file_descriptor, LOCK_EX);
+	}
+
+	FileLock(const FileLock &) = delete;
+	FileLock &operator=(const FileLock &) = delete;
+
+	~FileLock() {
+		flock(this->file_descriptor, LOCK_UN);
+		close(this->file_descriptor);
+	}
+};
+
+struct FactorizationCacheStatistics {
+	size_t hits = 0;
+	size_t misses = 0;
+	size_t evictions = 0;
+};
+
+/*
+ * An on-disk cache of LU factorizations shared by all runs that use the same
+ * directory. Every entry is a file named after the hash of the factorized
+ * matrix. Hits refresh the modification time of the file, so when the total
+ * size of the entries exceeds the limit, the least recently used ones are
+ * evicted. The statistics are kept in the directory as well, so they cover
+ * all runs.
+ */
+class FactorizationCache {
+	private:
+	std::filesystem::path directory;
+	size_t size_limit;
+
+	std::filesystem::path get_entry_path(uint64_t hash) const {
+		std::stringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << hash
+			 << FACTORIZATION_FILE_EXTENSION;
+		return this->directory / name.str();
+	}
+
+	std::filesystem::path get_statistics_path() const {
+		return this->directory / "statistics";
+	}
+
+	std::filesystem::path get_lock_path() const {
+		return this->directory / ".lock";
+	}
+
+	static size_t align(size_t offset) {
+		return (offset + FACTORIZATION_FILE_ALIGNMENT - 1) /
+			   FACTORIZATION_FILE_ALIGNMENT * FACTORIZATION_FILE_ALIGNMENT;
+	}
+
+	// Reads the statistics without locking, the caller holds the lock
+	FactorizationCacheStatistics read_statistics() const {
+		FactorizationCacheStatistics statistics;
+		std::ifstream file(this->get_statistics_path());
+		file >> statistics.hits >> statistics.misses >> statistics.evictions;
+		return statistics;
+	}
+
+	// Adds to the statistics, the caller holds the lock
+	void update_statistics(size_t hits, size_t misses, size_t evictions) {
+		FactorizationCacheStatistics statistics = this->read_statistics();
+		std::ofstream file(this->get_statistics_path());
+		file << statistics.hits + hits << " " << statistics.misses + misses
+			 << " " << statistics.evictions + evictions << std::endl;
+	}
+
+	// Maps an entry and checks that it is complete and belongs to the hash
+	template <typename T>
+	std::optional<LuFactorization<T>>
+	load(const std::filesystem::path &path, uint64_t hash, size_t size) const {
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(path, error)) {
+			return std::nullopt;
+		}
+
+		// An empty or unreadable entry cannot be mapped, which is a miss like
+		// any other broken entry
+		std::shared_ptr<MappedFile> file;
+		try {
+			file = std::make_shared<MappedFile>(path);
+		} catch (const std::runtime_error &exception) {
+			return std::nullopt;
+		}
+		if (file->get_size() < sizeof(FactorizationFileHeader)) {
+			return std::nullopt;
+		}
+
+		FactorizationFileHeader header;
+		std::memcpy(&header, file->get_data(), sizeof(header));
+		if (header.magic != FACTORIZATION_FILE_MAGIC ||
+			header.version != FACTORIZATION_FILE_VERSION ||
+			header.value_size != sizeof(T) || header.hash != hash ||
+			header.size != size || header.file_size != file->get_size() ||
+			header.factors_offset + size * size * sizeof(T) >
+				header.row_order_offset ||
+			header.row_order_offset + size * sizeof(uint64_t) >
+				header.file_size) {
+			return std::nullopt;
+		}
+
+		return LuFactorization<T>(
+			size,
+			header.permutation_sign,
+			std::shared_ptr<const T>(
+				file,
+				reinterpret_cast<const T *>(
+					file->get_data() + header.factors_offset
+				)
+			),
+			std::shared_ptr<const uint64_t>(
+				file,
+				reinterpret_cast<const uint64_t *>(
+					file->get_data() + header.row_order_offset
+				)
+			)
+		);
+	}
+
+	// Writes an entry to a temporary file first and then renames it, so other
+	// runs never see a partially written entry
+	template <typename T>
+	void store(
+		const std::filesystem::path &path,
+		uint64_t hash,
+		const LuFactorization<T> &factorization
+	) const {
+		const size_t size = factorization.get_size();
+
+		FactorizationFileHeader header;
+		header.magic = FACTORIZATION_FILE_MAGIC;
+		header.version = FACTORIZATION_FILE_VERSION;
+		header.value_size = sizeof(T);
+		header.hash = hash;
+		header.size = size;
+		header.permutation_sign = factorization.get_permutation_sign();
+		header.factors_offset = align(sizeof(header));
+		header.row_order_offset =
+			align(header.factors_offset + size * size * sizeof(T));
+		header.file_size = header.row_order_offset + size * sizeof(uint64_t);
+
+		std::string temporary_path =
+			(this->directory / ".entry-XXXXXX").string();
+		int file_descriptor = mkstemp(temporary_path.data());
+		if (file_descriptor == -1) {
+			throw std::runtime_error(
+				"Could not create a cache entry in " + this->directory.string()
+			);
+		}
+		// Entries are shared by every run that uses the directory
+		fchmod(file_descriptor, 0644);
+
+		const std::tuple<uint64_t, const void *, size_t> parts[] = {
+			{0, &header, sizeof(header)},
+			{header.factors_offset,
+			 factorization.get_factors(),
+			 size * size * sizeof(T)},
+			{header.row_order_offset,
+			 factorization.get_row_order(),
+			 size * sizeof(uint64_t)},
+		};
+		bool written = true;
+		for (const auto &[offset, data, length] : parts) {
+			const char *source = static_cast<const char *>(data);
+			size_t remaining = length;
+			off_t position = offset;
+			while (written && remaining > 0) {
+				ssize_t count =
+					pwrite(file_descriptor, source, remaining, position);
+				if (count <= 0) {
+					written = false;
+					break;
+				}
+				source += count;
+				remaining -= count;
+				position += count;
+			}
+		}
+		close(file_descriptor);
+
+		if (!written || rename(temporary_path.c_str(), path.c_str()) != 0) {
+			unlink(temporary_path.c_str());
+			throw std::runtime_error("Could not write the cache entry!");
+		}
+	}
+
+	// Removes the least recently used entries until the size limit is met and
+	// returns how many were removed. The caller holds the lock.
+	size_t evict() const {
+		std::vector<std::tuple<
+			std::filesystem::file_time_type,
+			uintmax_t,
+			std::filesystem::path>>
+			entries;
+		uintmax_t total_size = 0;
+		for (const auto &entry :
+			 std::filesystem::directory_iterator(this->directory)) {
+			if (entry.path().extension() != FACTORIZATION_FILE_EXTENSION ||
+				!entry.is_regular_file()) {
+				continue;
+			}
+			entries.emplace_back(
+				entry.last_write_time(), entry.file_size(), entry.path()
+			);
+			total_size += entry.file_size();
+		}
+		std::sort(entries.begin(), entries.end());
+
+		size_t evictions = 0;
+		for (const auto &[time, size, path] : entries) {
+			if (total_size <= this->size_limit) {
+				break;
+			}
+			std::error_code error;
+			if (std::filesystem::remove(path, error)) {
+				total_size -= size;
+				++evictions;
+			}
+		}
+		return evictions;
+	}
+
+	public:
+	FactorizationCache(
+		const std::filesystem::path &directory, size_t size_limit
+	)
+		: directory(directory), size_limit(size_limit) {
+		std::filesystem::create_directories(directory);
+	}
+
+	// Get the factorization of a square matrix from the cache, factorizing
+	// and storing it on a miss
+	template <typename T>
+	LuFactorization<T>
+	get_factorization(const Matrix<T> &map, bool parallel = true) {
+		if (map.get_number_of_rows() != map.get_number_of_columns()) {
+			throw std::runtime_error("Cannot factorize a non-square matrix!");
+		}
+
+		const uint64_t hash = hash_matrix(map);
+		const size_t size = map.get_number_of_rows();
+		const std::filesystem::path path = this->get_entry_path(hash);
+
+		{
+			FileLock lock(this->get_lock_path());
+			auto factorization = this->load<T>(path, hash, size);
+			if (factorization.has_value()) {
+				// Mark the entry as recently used
+				std::error_code error;
+				std::filesystem::last_write_time(
+					path, std::filesystem::file_time_type::clock::now(), error
+				);
+				this->update_statistics(1, 0, 0);
+				return *factorization;
+			}
+		}
+
+		// Factorizing does not need the lock, at worst two runs factorize the
+		// same matrix at once and one entry replaces the other
+		auto factorization = LuFactorization<T>::factorize(map, parallel);
+
+		FileLock lock(this->get_lock_path());
+		size_t evictions = 0;
+		if (align(sizeof(FactorizationFileHeader)) +
+				align(size * size * sizeof(T)) + size * sizeof(uint64_t) <=
+			this->size_limit) {
+			this->store(path, hash, factorization);
+			evictions = this->evict();
+		}
+		this->update_statistics(0, 1, evictions);
+
+		return factorization;
+	}
+
+	// Get the statistics of all runs that used the directory
+	FactorizationCacheStatistics get_statistics() const {
+		FileLock lock(this->get_lock_path());
+		return this->read_statistics();
+	}
+};
+
+#endif
@@ -0,0 +1,391 @@
+#include "matrix.hpp"
+#include "philox.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef FIXED_MATRIX_H
+#define FIXED_MATRIX_H
+
+// Loops up to this number of iterations get unrolled at compile time
+constexpr size_t FIXED_UNROLL_LIMIT = 8;
+
+template <typename Function, size_t... Indices>
+constexpr void
+fixed_for_unrolled(Function &&function, std::index_sequence<Indices...>) {
+	(function(Indices), ...);
+}
+
+// Calls the function for every index in [Start, End). The calls are unrolled
+// into straight code when there are at most FIXED_UNROLL_LIMIT of them.
+template <size_t Start, size_t End, typename Function>
+constexpr void fixed_for(Function &&function) {
+	if constexpr (End <= Start) {
+		return;
+	} else if constexpr (End - Start <= FIXED_UNROLL_LIMIT) {
+		fixed_for_unrolled(
+			[&function](size_t index) { function(Start + index); },
+			std::make_index_sequence<End - Start>{}
+		);
+	} else {
+		for (size_t index = Start; index < End; ++index) {
+			function(index);
+		}
+	}
+}
+
+template <
+	size_t Start,
+	size_t End,
+	bool Reverse,
+	typename Function,
+	size_t... Indices>
+constexpr void fixed_for_constant_unrolled(
+	Function &&function, std::index_sequence<Indices...>
+) {
+	(function(std::integral_constant<
+			  size_t,
+			  Reverse ? End - 1 - Indices : Start + Indices>{}),
+	 ...);
+}
+
+// Calls the function for every index in [Start, End), from the last one down
+// if Reverse is set. When the calls are unrolled, the index is passed as an
+// std::integral_constant, so that it can bound the loops inside it through
+// fixed_for_from, otherwise it is passed as a size_t.
+template <size_t Start, size_t End, bool Reverse = false, typename Function>
+constexpr void fixed_for_constant(Function &&function) {
+	if constexpr (End <= Start) {
+		return;
+	} else if constexpr (End - Start <= FIXED_UNROLL_LIMIT) {
+		fixed_for_constant_unrolled<Start, End, Reverse>(
+			function, std::make_index_sequence<End - Start>{}
+		);
+	} else if constexpr (Reverse) {
+		for (size_t index = End; index-- > Start;) {
+			function(index);
+		}
+	} else {
+		for (size_t index = Start; index < End; ++index) {
+			function(index);
+		}
+	}
+}
+
+// Calls the function for every index in [start + Offset, End). The calls are
+// unrolled like in fixed_for when the start is an std::integral_constant.
+template <size_t Offset, size_t End, typename Start, typename Function>
+constexpr void fixed_for_from(Start start, Function &&function) {
+	if constexpr (std::is_integral_v<Start>) {
+		for (size_t index = start + Offset; index < End; ++index) {
+			function(index);
+		}
+	} else {
+		fixed_for<Start::value + Offset, End>(function);
+	}
+}
+
+template <typename T> constexpr T fixed_abs(T value) {
+	return value < 0 ? -value : value;
+}
+
+// Aligns the storage to the largest power of two (up to a cache line) that
+// divides its size, so that whole matrices can be loaded into SIMD registers
+template <typename T, size_t Size> constexpr size_t fixed_alignment() {
+	size_t alignment = alignof(T);
+	while (alignment < 64 && (Size * sizeof(T)) % (alignment * 2) == 0) {
+		alignment *= 2;
+	}
+	return alignment;
+}
+
+/*
+ * A matrix whose dimensions are known at compile time. The data is stored
+ * inline in an std::array, so no allocation happens and all loops have
+ * constant bounds. The interface mirrors the one of Matrix<T>, except that
+ * the generators take no sizes, since those are part of the type.
+ */
+template <typename T, size_t R, size_t C> class FixedMatrix {
+	static_assert(R > 0 && C > 0, "A fixed matrix cannot be empty");
+
+	private:
+	alignas(fixed_alignment<T, R * C>()) std::array<T, R * C> data{};
+
+	public:
+	// Generate a random matrix with the given value range. The values are the
+	// ones Matrix<T>::random(R, C, min, max, seed) gives.
+	static FixedMatrix<T, R, C>
+	random(T min, T max, uint64_t seed = std::random_device()()) {
+		FixedMatrix<T, R, C> matrix;
+		for (size_t i = 0; i < R * C; ++i) {
+			matrix.data[i] = philox_uniform(seed, i, min, max);
+		}
+		return matrix;
+	}
+
+	// Generate an identity matrix
+	static constexpr FixedMatrix<T, R, C> identity() {
+		static_assert(R == C, "An identity matrix has to be square");
+
+		FixedMatrix<T, R, C> matrix;
+		fixed_for<0, R>([&matrix](size_t i) { matrix.at(i, i) = 1; });
+		return matrix;
+	}
+
+	// Generate a matrix filled with ones
+	static constexpr FixedMatrix<T, R, C> ones() {
+		FixedMatrix<T, R, C> matrix;
+		fixed_for<0, R * C>([&matrix](size_t i) { matrix.data[i] = 1; });
+		return matrix;
+	}
+
+	// Generate a Hilbert matrix
+	static constexpr FixedMatrix<T, R, C> hilbert() {
+		static_assert(R == C, "A Hilbert matrix has to be square");
+
+		FixedMatrix<T, R, C> matrix;
+		fixed_for<0, R>([&matrix](size_t row) {
+			fixed_for<0, C>([&matrix, row](size_t column) {
+				matrix.at(row, column) = 1.0 / (row + column + 1.0);
+			});
+		});
+		return matrix;
+	}
+
+	// Copy the values of a dynamically sized matrix of the same size
+	static FixedMatrix<T, R, C> from_matrix(const Matrix<T> &matrix) {
+		if (matrix.get_number_of_rows() != R ||
+			matrix.get_number_of_columns() != C) {
+			throw std::runtime_error("The matrix has the wrong size!");
+		}
+
+		FixedMatrix<T, R, C> fixed_matrix;
+		for (size_t row = 0; row < R; ++row) {
+			for (size_t column = 0; column < C; ++column) {
+				fixed_matrix.at(row, column) = matrix.at(row, column);
+			}
+		}
+		return fixed_matrix;
+	}
+
+	constexpr FixedMatrix() = default;
+
+	constexpr FixedMatrix(const std::array<T, R * C> &data) : data(data) {}
+
+	// Get the number of rows in the matrix
+	constexpr size_t get_number_of_rows() const { return R; }
+
+	// Get the number of columns in the matrix
+	constexpr size_t get_number_of_columns() const { return C; }
+
+	constexpr const T &at(size_t row, size_t column) const {
+		return this->data[row * C + column];
+	}
+
+	constexpr T &at(size_t row, size_t column) {
+		return this->data[row * C + column];
+	}
+
+	// Copy the values into a dynamically sized matrix
+	Matrix<T> to_matrix() const {
+		return Matrix<T>(
+			std::vector<T>(this->data.begin(), this->data.end()), R, C
+		);
+	}
+
+	// Calculate the product of the diagonal elements
+	constexpr double get_diagonal_product() const {
+		double product = 1;
+		fixed_for<0, (R < C ? R : C)>([this, &product](size_t position) {
+			product *= this->at(position, position);
+		});
+		return product;
+	}
+
+	constexpr double get_determinant() const;
+
+	constexpr FixedMatrix<T, R, C> get_inverse() const;
+
+	void save_to_file(const std::string &path) const {
+		this->to_matrix().save_to_file(path);
+	}
+
+	template <size_t P>
+	constexpr FixedMatrix<T, R, P>
+	operator*(const FixedMatrix<T, C, P> &rhs) const {
+		FixedMatrix<T, R, P> result;
+		fixed_for<0, R>([this, &rhs, &result](size_t row) {
+			fixed_for<0, C>([this, &rhs, &result, row](size_t i) {
+				const T value = this->at(row, i);
+				fixed_for<0, P>([&rhs, &result, row, i, value](size_t column) {
+					result.at(row, column) += value * rhs.at(i, column);
+				});
+			});
+		});
+		return result;
+	}
+
+	constexpr FixedMatrix<T, R, C> operator-(const FixedMatrix<T, R, C> &rhs
+	) const {
+		FixedMatrix<T, R, C> result;
+		fixed_for<0, R * C>([this, &rhs, &result](size_t i) {
+			result.data[i] = this->data[i] - rhs.data[i];
+		});
+		return result;
+	}
+};
+
+/*
+ * Brings the map to upper triangular form with partial pivoting, applying the
+ * same row operations to the right side. Returns the sign of the row
+ * permutation, or 0 if the map is singular. Up to FIXED_UNROLL_LIMIT columns
+ * every loop is unrolled, since the column is a compile-time constant that
+ * bounds the pivot search and the loop over the rows below it.
+ */
+template <typename T, size_t N, size_t K>
+constexpr int fixed_eliminate(
+	FixedMatrix<T, N, N> &map, FixedMatrix<T, N, K> &right_side
+) {
+	int sign = 1;
+
+	fixed_for_constant<0, N>([&](auto column) {
+		// The unrolled columns cannot break out, so the ones after a missing
+		// pivot are skipped
+		if (sign == 0) {
+			return;
+		}
+
+		size_t pivot_row = column;
+		fixed_for_from<1, N>(column, [&](size_t row) {
+			if (fixed_abs(map.at(row, column)) >
+				fixed_abs(map.at(pivot_row, column))) {
+				pivot_row = row;
+			}
+		});
+
+		if (map.at(pivot_row, column) == 0) {
+			sign = 0;
+			return;
+		}
+
+		if (pivot_row != column) {
+			sign = -sign;
+			fixed_for<0, N>([&](size_t i) {
+				T value = map.at(column, i);
+				map.at(column, i) = map.at(pivot_row, i);
+				map.at(pivot_row, i) = value;
+			});
+			fixed_for<0, K>([&](size_t i) {
+				T value = right_side.at(column, i);
+				right_side.at(column, i) = right_side.at(pivot_row, i);
+				right_side.at(pivot_row, i) = value;
+			});
+		}
+
+		fixed_for_from<1, N>(column, [&](size_t row) {
+			// The entries left of the column are zero in both rows, so the
+			// whole row can be updated with a loop of constant length
+			const T multiplicator =
+				-map.at(row, column) / map.at(column, column);
+			fixed_for<0, N>([&](size_t i) {
+				map.at(row, i) += multiplicator * map.at(column, i);
+			});
+			fixed_for<0, K>([&](size_t i) {
+				right_side.at(row, i) +=
+					multiplicator * right_side.at(column, i);
+			});
+		});
+	});
+
+	return sign;
+}
+
+// Solves the system with a square map for all columns of the right side
+template <typename T, size_t N, size_t K>
+constexpr FixedMatrix<T, N, K> solve_system_of_equations(
+	FixedMatrix<T, N, N> map, FixedMatrix<T, N, K> right_side
+) {
+	if (fixed_eliminate(map, right_side) == 0) {
+		throw std::runtime_error("The matrix is singular!");
+	}
+
+	// Back-substitution from the last row up
+	fixed_for_constant<0, N, true>([&](auto row) {
+		fixed_for_from<1, N>(row, [&](size_t column) {
+			const T coefficient = map.at(row, column);
+			fixed_for<0, K>([&](size_t i) {
+				right_side.at(row, i) -= coefficient * right_side.at(column, i);
+			});
+		});
+		const T diagonal = map.at(row, row);
+		fixed_for<0, K>([&](size_t i) { right_side.at(row, i) /= diagonal; });
+	});
+
+	return right_side;
+}
+
+template <typename T, size_t R, size_t C>
+constexpr double FixedMatrix<T, R, C>::get_determinant() const {
+	static_assert(R == C, "Cannot compute determinant of a non-square matrix");
+
+	FixedMatrix<T, R, C> map = *this;
+	FixedMatrix<T, R, 1> right_side;
+	const int sign = fixed_eliminate(map, right_side);
+	return sign * map.get_diagonal_product();
+}
+
+template <typename T, size_t R, size_t C>
+constexpr FixedMatrix<T, R, C> FixedMatrix<T, R, C>::get_inverse() const {
+	static_assert(R == C, "Cannot invert a non-square matrix");
+
+	return solve_system_of_equations(*this, FixedMatrix<T, R, C>::identity());
+}
+
+// The Frobenius norm, with the sum of squares scaled by the largest value like
+// the one of Matrix<T>, so that it neither overflows nor underflows
+template <typename T, size_t R, size_t C>
+double abs(const FixedMatrix<T, R, C> &matrix) {
+	double scale = 0;
+	fixed_for<0, R>([&](size_t row) {
+		fixed_for<0, C>([&](size_t column) {
+			const double absolute_value =
+				std::abs(double(matrix.at(row, column)));
+			// Written so that a NaN sticks once it has been seen
+			if (absolute_value > scale || absolute_value != absolute_value) {
+				scale = absolute_value;
+			}
+		});
+	});
+	// Infinities and NaNs propagate to the result
+	if (scale == 0 || !std::isfinite(scale)) {
+		return scale;
+	}
+
+	const double inverse_scale = 1 / scale;
+	double sum_of_squares = 0;
+	fixed_for<0, R>([&](size_t row) {
+		fixed_for<0, C>([&](size_t column) {
+			const double scaled_value = matrix.at(row, column) * inverse_scale;
+			sum_of_squares += scaled_value * scaled_value;
+		});
+	});
+	return scale * sqrt(sum_of_squares);
+}
+
+template <typename T, size_t R, size_t C>
+std::ostream &
+operator<<(std::ostream &stream, const FixedMatrix<T, R, C> &matrix) {
+	return stream << matrix.to_matrix();
+}
+
+#endif
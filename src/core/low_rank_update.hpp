@@ -0,0 +1,232 @@
+#include "lu_factorization.hpp"
+#include "matrix.hpp"
+#include "matrix_expression.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#ifndef LOW_RANK_UPDATE_H
+#define LOW_RANK_UPDATE_H
+
+// Updates whose capacitance matrix has a larger condition number (see
+// factorize_capacitance) are considered too ill-conditioned to go through,
+// they would lose about half of the digits of a double
+constexpr double LOW_RANK_UPDATE_CONDITION_LIMIT = 1e8;
+
+// The update of a matrix A to A + u * v^T, where u and v have k columns
+template <typename T> struct RankUpdate {
+	Matrix<T> u;
+	Matrix<T> v;
+};
+
+// Get the update that replaces the given rows of the map by the rows of
+// new_rows
+template <typename T>
+RankUpdate<T> get_row_replacement(
+	const Matrix<T> &map,
+	const std::vector<size_t> &rows,
+	const Matrix<T> &new_rows
+) {
+	const size_t rank = rows.size();
+	if (new_rows.get_number_of_rows() != rank ||
+		new_rows.get_number_of_columns() != map.get_number_of_columns()) {
+		throw std::runtime_error("The replaced rows have the wrong size!");
+	}
+
+	MatrixStorage<T> u(map.get_number_of_rows() * rank, 0);
+	MatrixStorage<T> v(map.get_number_of_columns() * rank);
+	for (size_t i = 0; i < rank; ++i) {
+		u[rows[i] * rank + i] = 1;
+		for (size_t column = 0; column < map.get_number_of_columns();
+			 ++column) {
+			v[column * rank + i] =
+				new_rows.at(i, column) - map.at(rows[i], column);
+		}
+	}
+
+	return RankUpdate<T>{
+		Matrix<T>(u, map.get_number_of_rows(), rank),
+		Matrix<T>(v, map.get_number_of_columns(), rank)
+	};
+}
+
+// Get the update that replaces the given columns of the map by the columns of
+// new_columns
+template <typename T>
+RankUpdate<T> get_column_replacement(
+	const Matrix<T> &map,
+	const std::vector<size_t> &columns,
+	const Matrix<T> &new_columns
+) {
+	const size_t rank = columns.size();
+	if (new_columns.get_number_of_columns() != rank ||
+		new_columns.get_number_of_rows() != map.get_number_of_rows()) {
+		throw std::runtime_error("The replaced columns have the wrong size!");
+	}
+
+	MatrixStorage<T> u(map.get_number_of_rows() * rank);
+	MatrixStorage<T> v(map.get_number_of_columns() * rank, 0);
+	for (size_t i = 0; i < rank; ++i) {
+		for (size_t row = 0; row < map.get_number_of_rows(); ++row) {
+			u[row * rank + i] =
+				new_columns.at(row, i) - map.at(row, columns[i]);
+		}
+		v[columns[i] * rank + i] = 1;
+	}
+
+	return RankUpdate<T>{
+		Matrix<T>(u, map.get_number_of_rows(), rank),
+		Matrix<T>(v, map.get_number_of_columns(), rank)
+	};
+}
+
+// Factorize the k x k capacitance matrix C = I + v^T * A^-1 * u, unless it is
+// singular or too ill-conditioned to update through. Forming C can cancel
+// out most of its digits, which the condition number of C alone does not
+// show (it is always 1 for k = 1), so C^-1 is measured against the terms it
+// is formed from instead. C is small, so its inverse is computed exactly.
+template <typename T>
+std::optional<LuFactorization<T>>
+factorize_capacitance(const Matrix<T> &projected_update) {
+	const size_t rank = projected_update.get_number_of_rows();
+	Matrix<T> capacitance = Matrix<T>::identity(rank) + projected_update;
+
+	auto factorization = LuFactorization<T>::factorize(capacitance, false);
+	if (factorization.is_singular()) {
+		return std::nullopt;
+	}
+
+	const double condition_number =
+		(1 + projected_update.get_one_norm()) *
+		factorization.get_inverse(false).get_one_norm();
+	// Written so that a NaN counts as ill-conditioned too
+	if (!(condition_number <= LOW_RANK_UPDATE_CONDITION_LIMIT)) {
+		return std::nullopt;
+	}
+	return factorization;
+}
+
+/*
+ * Solves systems with the updated matrix A + u * v^T given the factorization
+ * of A, using the Sherman-Morrison-Woodbury formula
+ *
+ *     (A + u * v^T)^-1 = A^-1 - A^-1 * u * C^-1 * v^T * A^-1,
+ *     C = I + v^T * A^-1 * u.
+ *
+ * Preparing the update costs O(n^2 * k) and every solve O(n^2 + n * k) per
+ * right side instead of the O(n^3) of a new factorization. When C is
+ * ill-conditioned, the formula would lose too much precision, so the updated
+ * matrix is factorized from scratch instead.
+ */
+template <typename T> class LowRankUpdate {
+	private:
+	LuFactorization<T> factorization;
+	std::optional<Matrix<T>> update_solutions; // A^-1 * u
+	std::optional<Matrix<T>> v_transposed;
+	std::optional<LuFactorization<T>> capacitance;
+
+	// Turns solutions of the original system into solutions of the updated
+	// one
+	Matrix<T> apply_update(const Matrix<T> &solutions) const {
+		if (!this->capacitance.has_value()) {
+			return solutions;
+		}
+
+		Matrix<T> projections = *this->v_transposed * solutions;
+		Matrix<T> corrections = this->capacitance->solve(projections, false);
+		return solutions - *this->update_solutions * corrections;
+	}
+
+	public:
+	// The map is only used when the update has to fall back to factorizing
+	// the updated matrix
+	LowRankUpdate(
+		const Matrix<T> &map,
+		const LuFactorization<T> &factorization,
+		const RankUpdate<T> &update,
+		bool parallel = true
+	)
+		: factorization(factorization) {
+		if (update.u.get_number_of_rows() != factorization.get_size() ||
+			update.v.get_number_of_rows() != factorization.get_size() ||
+			update.u.get_number_of_columns() !=
+				update.v.get_number_of_columns()) {
+			throw std::runtime_error("The update has the wrong size!");
+		}
+
+		Matrix<T> v_transposed = update.v.get_transpose();
+		// A singular A cannot be updated through, but A + u * v^T may well be
+		// regular, so it is factorized from scratch like when C is singular
+		if (!factorization.is_singular()) {
+			Matrix<T> update_solutions = factorization.solve(update.u, parallel);
+			Matrix<T> projected_update = v_transposed * update_solutions;
+
+			this->capacitance = factorize_capacitance(projected_update);
+			if (this->capacitance.has_value()) {
+				this->update_solutions = std::move(update_solutions);
+				this->v_transposed = std::move(v_transposed);
+				return;
+			}
+		}
+
+		Matrix<T> updated_map = map + update.u * v_transposed;
+		this->factorization = LuFactorization<T>::factorize(updated_map, parallel);
+	}
+
+	// Whether the updated matrix had to be factorized from scratch
+	bool was_refactored() const { return !this->capacitance.has_value(); }
+
+	// det(A + u * v^T) = det(A) * det(C)
+	const double get_determinant() const {
+		double determinant = this->factorization.get_determinant();
+		if (this->capacitance.has_value()) {
+			determinant *= this->capacitance->get_determinant();
+		}
+		return determinant;
+	}
+
+	Matrix<T> solve(const Matrix<T> &right_side, bool parallel = true) const {
+		return this->apply_update(
+			this->factorization.solve(right_side, parallel)
+		);
+	}
+
+	// The inverse of A is computed from its factorization first, so when it
+	// is already known, update_inverse() is cheaper
+	Matrix<T> get_inverse(bool parallel = true) const {
+		return this->apply_update(this->factorization.get_inverse(parallel));
+	}
+};
+
+// Get the inverse of A + u * v^T from the inverse of A in O(n^2 * k), see
+// LowRankUpdate. The map is only used when the update has to fall back to
+// inverting the updated matrix.
+template <typename T>
+Matrix<T> update_inverse(
+	const Matrix<T> &map,
+	const Matrix<T> &inverse,
+	const RankUpdate<T> &update,
+	bool parallel = true
+) {
+	if (update.u.get_number_of_columns() != update.v.get_number_of_columns()) {
+		throw std::runtime_error("The update has the wrong size!");
+	}
+
+	Matrix<T> update_solutions = inverse * update.u;
+	Matrix<T> v_transposed = update.v.get_transpose();
+	Matrix<T> projected_update = v_transposed * update_solutions;
+
+	auto capacitance_factorization = factorize_capacitance(projected_update);
+	if (!capacitance_factorization.has_value()) {
+		Matrix<T> updated_map = map + update.u * v_transposed;
+		return updated_map.get_inverse(parallel);
+	}
+
+	Matrix<T> projections = v_transposed * inverse;
+	Matrix<T> corrections = capacitance_factorization->solve(projections);
+	return inverse - update_solutions * corrections;
+}
+
+#endif
@@ -0,0 +1,172 @@
+#include "condition_estimate.hpp"
+#include "eliminable_matrix.hpp"
+#include "matrix.hpp"
+#include "matrix_expression.hpp"
+#include "triangular_solve.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <vector>
+
+#ifndef LU_FACTORIZATION_H
+#define LU_FACTORIZATION_H
+
+/*
+ * The result of GEM on a square matrix kept for later use: P * A = L * U,
+ * where L has a unit diagonal and is stored below the diagonal, U is stored on
+ * and above it and row i of P * A is row row_order[i] of A. The factors are
+ * only referred to, so they can live in a vector as well as in a mapped file.
+ */
+template <typename T> class LuFactorization {
+	private:
+	size_t size;
+	int permutation_sign;
+	std::shared_ptr<const T> factors;
+	std::shared_ptr<const uint64_t> row_order;
+
+	public:
+	// Factorize a square matrix with GEM
+	static LuFactorization<T>
+	factorize(const Matrix<T> &map, bool parallel = true) {
+		if (map.get_number_of_rows() != map.get_number_of_columns()) {
+			throw std::runtime_error("Cannot factorize a non-square matrix!");
+		}
+
+		EliminableMatrix<T> eliminable_matrix = map.get_eliminable();
+		eliminable_matrix.perform_gem(parallel);
+
+		auto factors = std::make_shared<std::vector<T>>(
+			eliminable_matrix.data.begin(), eliminable_matrix.data.end()
+		);
+		auto row_order = std::make_shared<std::vector<uint64_t>>(
+			eliminable_matrix.row_order.begin(),
+			eliminable_matrix.row_order.end()
+		);
+		return LuFactorization<T>(
+			map.get_number_of_rows(),
+			eliminable_matrix.permutation_sign,
+			std::shared_ptr<const T>(factors, factors->data()),
+			std::shared_ptr<const uint64_t>(row_order, row_order->data())
+		);
+	}
+
+	LuFactorization(
+		size_t size,
+		int permutation_sign,
+		std::shared_ptr<const T> factors,
+		std::shared_ptr<const uint64_t> row_order
+	)
+		: size(size), permutation_sign(permutation_sign),
+		  factors(std::move(factors)), row_order(std::move(row_order)) {}
+
+	size_t get_size() const { return this->size; }
+
+	int get_permutation_sign() const { return this->permutation_sign; }
+
+	// Get the factors as a row-major array of size * size values
+	const T *get_factors() const { return this->factors.get(); }
+
+	// Get the original index of every row of the factors
+	const uint64_t *get_row_order() const { return this->row_order.get(); }
+
+	const T &at(size_t row, size_t column) const {
+		return this->factors.get()[row * this->size + column];
+	}
+
+	// Whether there is a zero on the diagonal of U, so nothing can be solved
+	bool is_singular() const {
+		for (size_t position = 0; position < this->size; ++position) {
+			if (this->at(position, position) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	const double get_determinant() const {
+		double product = this->permutation_sign;
+		for (size_t position = 0; position < this->size; ++position) {
+			product *= this->at(position, position);
+		}
+		return product;
+	}
+
+	// Solve A * X = B by substituting forward through L and backward through
+	// U. Every column of B is independent, so the columns are split between
+	// the threads in whole cache lines.
+	Matrix<T> solve(const Matrix<T> &right_side, bool parallel = true) const {
+		if (right_side.get_number_of_rows() != this->size) {
+			throw std::runtime_error("The number of rows does not match!");
+		}
+		if (this->is_singular()) {
+			throw std::runtime_error("The matrix is singular!");
+		}
+
+		const size_t number_of_columns = right_side.get_number_of_columns();
+		MatrixStorage<T> solution(this->size * number_of_columns);
+		for (size_t row = 0; row < this->size; ++row) {
+			const T *source =
+				&right_side.at(this->row_order.get()[row], 0);
+			std::copy(
+				source,
+				source + number_of_columns,
+				&solution[row * number_of_columns]
+			);
+		}
+
+		auto substitute = [this, &solution, number_of_columns](
+							  size_t start_column, size_t end_column, size_t
+						  ) {
+			for (size_t row = 0; row < this->size; ++row) {
+				T *target = &solution[row * number_of_columns];
+				for (size_t i = 0; i < row; ++i) {
+					const T factor = this->at(row, i);
+					const T *source = &solution[i * number_of_columns];
+					for (size_t column = start_column; column < end_column;
+						 ++column) {
+						target[column] -= factor * source[column];
+					}
+				}
+			}
+
+			solve_upper_triangular_columns(
+				&this->at(0, 0),
+				this->size,
+				solution.data(),
+				number_of_columns,
+				this->size,
+				start_column,
+				end_column
+			);
+		};
+
+		if (parallel) {
+			for_each_column_chunk<T>(number_of_columns, substitute);
+		} else {
+			substitute(0, number_of_columns, 0);
+		}
+
+		return Matrix<T>(std::move(solution), this->size, number_of_columns);
+	}
+
+	// Estimate the accuracy of solutions computed with the factorization,
+	// given the 1-norm of the factorized matrix
+	AccuracyEstimate<T> estimate_accuracy(T map_one_norm) const {
+		return ::estimate_accuracy(
+			this->factors.get(),
+			this->size,
+			this->row_order.get(),
+			this->size,
+			map_one_norm
+		);
+	}
+
+	Matrix<T> get_inverse(bool parallel = true) const {
+		return this->solve(Matrix<T>::identity(this->size), parallel);
+	}
+};
+
+#endif
@@ -1,13 +1,22 @@
+#include "./condition_estimate.hpp"
+#include "./matrix_expression.hpp"
+#include "./matrix_file.hpp"
 #include "./permutations.hpp"
+#include "./philox.hpp"
+#include "./uninitialized_allocator.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory_resource>
 #include <ostream>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #ifndef MATRIX_H
@@ -19,17 +28,50 @@ enum class DeterminantMethod {
 	Definition,
 };
 
+// How the upper triangle left by GEM is solved for the right side
+enum class BackSubstitutionMethod {
+	// Blocked backward substitution on the right side only
+	Triangular,
+	// Elimination of everything above the diagonal and normalization
+	Jordan,
+};
+
 template <typename T> class Matrix;
 template <typename T> class EliminableMatrix;
+template <typename T> class LuFactorization;
 
 template <typename T>
-Matrix<T>
-solve_system_of_equations(Matrix<T> map, Matrix<T> right_side, bool parallel);
+Matrix<T> solve_system_of_equations(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+);
+
+template <typename T> struct EstimatedSolution;
 
-template <typename T> class Matrix {
+template <typename T>
+EstimatedSolution<T> solve_system_of_equations_with_estimate(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+);
+
+template <typename T> class Matrix : public MatrixExpressionBase {
 	friend Matrix<T> solve_system_of_equations<T>(
-		Matrix<T> map, Matrix<T> right_side, bool parallel
+		Matrix<T> map,
+		Matrix<T> right_side,
+		bool parallel,
+		BackSubstitutionMethod back_substitution_method
+	);
+	friend EstimatedSolution<T> solve_system_of_equations_with_estimate<T>(
+		Matrix<T> map,
+		Matrix<T> right_side,
+		bool parallel,
+		BackSubstitutionMethod back_substitution_method
 	);
+	friend LuFactorization<T>;
 
 	private:
 	// Convert the matrix to an eliminable matrix for Gaussian elimination
@@ -43,7 +85,7 @@ template <typename T> class Matrix {
 			throw std::runtime_error("The number of rows does not match!");
 		}
 
-		std::vector<T> new_data;
+		MatrixStorage<T> new_data;
 		new_data.reserve(
 			this->number_of_rows *
 			(this->number_of_columns + rhs.number_of_columns)
@@ -74,7 +116,7 @@ template <typename T> class Matrix {
 
 	// Extract a range of columns from the matrix with specified end
 	Matrix<T> extract_column_range(size_t start, size_t end) const {
-		std::vector<T> extracted_data;
+		MatrixStorage<T> extracted_data;
 		extracted_data.reserve((end - start) * this->get_number_of_rows());
 
 		for (size_t row = 0; row < this->get_number_of_rows(); ++row) {
@@ -89,32 +131,45 @@ template <typename T> class Matrix {
 	protected:
 	size_t number_of_rows;
 	size_t number_of_columns;
-	std::vector<T> data;
+	MatrixStorage<T> data;
 
 	public:
+	using value_type = T;
+
 	// Generate a random matrix with specified size and value range
-	static Matrix<T> random(size_t size, T min, T max) {
-		return Matrix::random(size, size, min, max);
+	static Matrix<T> random(
+		size_t size, T min, T max, uint64_t seed = std::random_device()()
+	) {
+		return Matrix::random(size, size, min, max, seed);
 	}
 
-	// Generate a random matrix with specified dimensions and value range
-	static Matrix<T>
-	random(size_t number_of_rows, size_t number_of_columns, T min, T max) {
-		std::random_device rd;
-		std::mt19937 gen(rd());
-
-		std::vector<T> data(number_of_rows * number_of_columns);
-		std::uniform_real_distribution<T> dist(min, max);
-		for (size_t i = 0; i < data.size(); ++i) {
-			data[i] = dist(gen);
-		}
+	// Generate a random matrix with specified dimensions and value range. The
+	// values only depend on the seed and their position, so they are filled
+	// in parallel and are the same for any number of threads.
+	static Matrix<T> random(
+		size_t number_of_rows,
+		size_t number_of_columns,
+		T min,
+		T max,
+		uint64_t seed = std::random_device()()
+	) {
+		MatrixStorage<T> data(number_of_rows * number_of_columns);
+		for_each_row_chunk(
+			number_of_rows, [&](size_t start_row, size_t end_row, size_t) {
+				for (size_t i = start_row * number_of_columns;
+					 i < end_row * number_of_columns;
+					 ++i) {
+					data[i] = philox_uniform(seed, i, min, max);
+				}
+			}
+		);
 
-		return Matrix<T>(data, number_of_rows, number_of_columns);
+		return Matrix<T>(std::move(data), number_of_rows, number_of_columns);
 	}
 
 	// Generate an identity matrix of specified size
 	static Matrix<T> identity(const size_t size) {
-		std::vector<T> data(size * size, 0);
+		MatrixStorage<T> data(size * size, 0);
 		for (size_t i = 0; i < size; ++i) {
 			data[i * size + i] = 1;
 		}
@@ -129,13 +184,13 @@ template <typename T> class Matrix {
 	// Generate a matrix filled with ones with specified dimensions
 	static Matrix<T>
 	ones(const size_t number_of_rows, const size_t number_of_columns) {
-		std::vector<T> data(number_of_rows * number_of_columns, 1);
+		MatrixStorage<T> data(number_of_rows * number_of_columns, 1);
 		return Matrix<T>(data, number_of_rows, number_of_columns);
 	}
 
 	// Generate a Hilbert matrix of specified size
 	static Matrix<T> hilbert(const size_t size) {
-		std::vector<T> data(size * size);
+		MatrixStorage<T> data(size * size);
 		for (int row = 0; row < size; ++row) {
 			for (int column = 0; column < size; ++column) {
 				data[row * size + column] = 1.0 / (row + column + 1.0);
@@ -144,11 +199,27 @@ template <typename T> class Matrix {
 		return Matrix<T>(data, size, size);
 	}
 
-	// Load a matrix from a file
+	// Load a matrix from a text or a binary file
 	static Matrix<T> from_file(const std::string &file_path) {
-		std::ifstream file(file_path);
+		std::ifstream file(file_path, std::ios::binary);
+		if (!file) {
+			throw std::runtime_error("Could not open " + file_path);
+		}
+
+		if (read_binary_matrix_magic(file)) {
+			uint64_t shape[2];
+			read_binary_matrix_shape(file, shape, sizeof(T));
+			MatrixStorage<T> data(shape[0] * shape[1]);
+			file.read(
+				reinterpret_cast<char *>(data.data()), data.size() * sizeof(T)
+			);
+			if (!file) {
+				throw std::runtime_error("The binary matrix file is truncated!");
+			}
+			return Matrix<T>(std::move(data), shape[0], shape[1]);
+		}
 
-		std::vector<T> data;
+		MatrixStorage<T> data;
 		size_t number_of_rows = 0;
 		size_t number_of_columns = 0;
 
@@ -179,16 +250,58 @@ template <typename T> class Matrix {
 	// Constructor for the Matrix class
 	Matrix(
 		std::vector<T> data, size_t number_of_rows, size_t number_of_columns
-	) {
-		if (data.size() != (number_of_rows * number_of_columns)) {
+	)
+		: Matrix(
+			  MatrixStorage<T>(data.begin(), data.end()),
+			  number_of_rows,
+			  number_of_columns
+		  ) {}
+
+	// Constructor taking data that is already allocated from a memory
+	// resource. The matrix keeps allocating from that resource.
+	Matrix(
+		MatrixStorage<T> data,
+		size_t number_of_rows,
+		size_t number_of_columns
+	)
+		: number_of_rows(number_of_rows), number_of_columns(number_of_columns),
+		  data(std::move(data)) {
+		if (this->data.size() != (number_of_rows * number_of_columns)) {
 			throw std::runtime_error("The supplied data has the wrong size");
 		}
+	}
 
-		// We could use a member initializer list here but I find this a little
-		// better since it's a bit more explicit
-		this->data = data;
-		this->number_of_rows = number_of_rows;
-		this->number_of_columns = number_of_columns;
+	// Copy a matrix into memory allocated from the given resource
+	Matrix(const Matrix<T> &matrix, std::pmr::memory_resource *resource)
+		: number_of_rows(matrix.number_of_rows),
+		  number_of_columns(matrix.number_of_columns),
+		  data(matrix.data, resource) {}
+
+	// Evaluate a matrix expression row by row in parallel
+	template <
+		typename E,
+		typename = std::enable_if_t<
+			is_matrix_expression_v<E> && !std::is_base_of_v<Matrix<T>, E>>>
+	Matrix(const E &expression)
+		: number_of_rows(expression.get_number_of_rows()),
+		  number_of_columns(expression.get_number_of_columns()),
+		  data(number_of_rows * number_of_columns) {
+		// Every worker clears its own rows, so it touches their pages first
+		for_each_row_chunk(
+			this->number_of_rows,
+			[this, &expression](size_t start_row, size_t end_row, size_t) {
+				std::fill(
+					this->data.begin() + start_row * this->number_of_columns,
+					this->data.begin() + end_row * this->number_of_columns,
+					0
+				);
+				for (size_t row = start_row; row < end_row; ++row) {
+					expression.accumulate_row(
+						row, &this->data[row * this->number_of_columns], 1
+					);
+				}
+			}
+		);
 	}
 
 	// Get the number of rows in the matrix
@@ -236,118 +349,92 @@ template <typename T> class Matrix {
 		case DeterminantMethod::Elimination: {
 			EliminableMatrix<T> eliminable_matrix = this->get_eliminable();
 			eliminable_matrix.perform_gem(false);
-			return eliminable_matrix.get_diagonal_product();
+			return eliminable_matrix.get_diagonal_product() *
+				   eliminable_matrix.permutation_sign;
 		}
 		case DeterminantMethod::ParallelElimination: {
 			EliminableMatrix<T> eliminable_matrix = this->get_eliminable();
 			eliminable_matrix.perform_gem(true);
-			return eliminable_matrix.get_diagonal_product();
+			return eliminable_matrix.get_diagonal_product() *
+				   eliminable_matrix.permutation_sign;
 		}
 		default:
 			throw std::runtime_error("Unknown determinant method!");
 		}
 	}
 
-	Matrix<T> get_inverse(bool parallel = true) const {
-		if (this->number_of_rows != this->number_of_columns) {
-			throw std::runtime_error("Cannot invert a non-square matrix!");
+	Matrix<T> get_transpose() const {
+		MatrixStorage<T> transposed_data(this->data.size());
+		for (size_t row = 0; row < this->number_of_rows; ++row) {
+			for (size_t column = 0; column < this->number_of_columns;
+				 ++column) {
+				transposed_data[column * this->number_of_rows + row] =
+					this->at(row, column);
+			}
 		}
-
-		return solve_system_of_equations(
-			*this, Matrix<T>::identity(this->number_of_rows), parallel
+		return Matrix<T>(
+			transposed_data, this->number_of_columns, this->number_of_rows
 		);
 	}
 
-	const T &at(size_t row, size_t column) const {
-		return this->data[row * this->number_of_columns + column];
-	}
-
-	void save_to_file(const std::string &path) const {
-		std::ofstream file(path);
-
+	// Calculate the largest sum of absolute values in a column
+	const double get_one_norm() const {
+		std::vector<double> column_sums(this->number_of_columns, 0);
 		for (size_t row = 0; row < this->number_of_rows; ++row) {
 			for (size_t column = 0; column < this->number_of_columns;
 				 ++column) {
-				file << this->at(row, column);
-				if (column < this->number_of_columns - 1) {
-					file << " ";
-				}
-			}
-			if (row < this->number_of_rows - 1) {
-				file << std::endl;
+				column_sums[column] += std::abs(this->at(row, column));
 			}
 		}
 
-		file.close();
-	}
-
-	const Matrix<T> operator*(const Matrix<T> &rhs) const {
-		// Matrix A is R^t -> R^r and Matrix B is R^c -> R^p but we cannot
-		// compose R^c -> R^p and R^t -> R^r since p != t
-		if (this->number_of_columns != rhs.number_of_rows) {
-			std::stringstream error_message;
-			error_message << "Cannot compose R^" << this->number_of_columns
-						  << " -> R^" << this->number_of_rows << " with R^"
-						  << rhs.number_of_columns << "R^" << rhs.number_of_rows
-						  << "!";
-			throw std::runtime_error(error_message.str());
+		double norm = 0;
+		for (double column_sum : column_sums) {
+			norm = std::max(norm, column_sum);
 		}
-		// Matrix A is R^t -> R^r and Matrix B is R^c -> R^t. So when we compose
-		// R^c -> R^t and R^t -> R^r, we get R^c -> R^r
-		size_t result_number_of_rows = this->number_of_rows;
-		size_t result_number_of_columns = rhs.number_of_columns;
-		std::vector<T> result_data(
-			result_number_of_rows * result_number_of_columns, 0
-		);
+		return norm;
+	}
 
-		for (size_t row = 0; row < result_number_of_rows; ++row) {
-			for (size_t column = 0; column < result_number_of_columns;
-				 ++column) {
-				result_data[row * result_number_of_columns + column] = 0;
-				for (size_t i = 0; i < this->number_of_columns; ++i) {
-					result_data[row * result_number_of_columns + column] +=
-						this->at(row, i) * rhs.at(i, column);
-				}
-			}
+	Matrix<T> get_inverse(
+		bool parallel = true,
+		BackSubstitutionMethod back_substitution_method =
+			BackSubstitutionMethod::Triangular
+	) const {
+		if (this->number_of_rows != this->number_of_columns) {
+			throw std::runtime_error("Cannot invert a non-square matrix!");
 		}
 
-		return Matrix<T>(
-			result_data, result_number_of_rows, result_number_of_columns
+		return solve_system_of_equations(
+			*this,
+			Matrix<T>::identity(this->number_of_rows),
+			parallel,
+			back_substitution_method
 		);
 	}
 
-	const Matrix<T> operator-(const Matrix<T> &rhs) const {
-		if (this->number_of_rows != rhs.number_of_rows ||
-			this->number_of_columns != rhs.number_of_columns) {
-			throw std::runtime_error(
-				"Cannot subtract matrices of different sizes!"
-			);
-		}
+	const T &at(size_t row, size_t column) const {
+		return this->data[row * this->number_of_columns + column];
+	}
 
-		std::vector<T> result_data(
-			this->number_of_rows * this->number_of_columns, 0
+	void save_to_file(const std::string &path, bool binary = false) const {
+		MatrixFileWriter writer(
+			path, this->number_of_rows, this->number_of_columns, binary
 		);
+		writer.write_rows(this->data.data(), this->number_of_rows);
+	}
 
-		for (size_t i = 0; i < this->data.size(); ++i) {
-			result_data[i] = this->data[i] - rhs.data[i];
+	// Add a multiple of a row to the target
+	void accumulate_row(size_t row, T *target, T factor) const {
+		const T *values = &this->data[row * this->number_of_columns];
+		for (size_t column = 0; column < this->number_of_columns; ++column) {
+			target[column] += factor * values[column];
 		}
-
-		return Matrix<T>(
-			result_data, this->number_of_rows, this->number_of_columns
-		);
 	}
-};
 
-template <typename T> const double abs(const Matrix<T> &matrix) {
-	double sum = 0;
-	for (size_t row = 0; row < matrix.get_number_of_rows(); ++row) {
-		for (size_t column = 0; column < matrix.get_number_of_columns();
-			 ++column) {
-			sum += pow(matrix.at(row, column), 2);
-		}
+	// The product is evaluated lazily, see MatrixProduct
+	MatrixProduct<T> operator*(const Matrix<T> &rhs) const {
+		return MatrixProduct<T>(*this, rhs);
 	}
-	return sqrt(sum);
-}
+};
 
 template <typename T>
 std::ostream &operator<<(std::ostream &stream, const Matrix<T> &matrix) {
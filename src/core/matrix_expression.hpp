@@ -0,0 +1,421 @@
+#include "numa.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory_resource>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef MATRIX_EXPRESSION_H
+#define MATRIX_EXPRESSION_H
+
+template <typename T> class Matrix;
+
+/*
+ * Every matrix and every lazily evaluated combination of matrices derives from
+ * this tag. An expression knows its size and can add a multiple of any of its
+ * rows to a buffer, which is all that is needed to evaluate it row by row
+ * without materializing any intermediate matrix.
+ */
+struct MatrixExpressionBase {};
+
+template <typename E>
+constexpr bool is_matrix_expression_v =
+	std::is_base_of_v<MatrixExpressionBase, E>;
+
+// Matrices are stored by reference in an expression, while nested expressions
+// are small and stored by value so that they cannot dangle
+template <typename E>
+using expression_storage_t = std::conditional_t<
+	std::is_base_of_v<Matrix<typename E::value_type>, E>,
+	const Matrix<typename E::value_type> &,
+	const E>;
+
+// Splits the rows into one contiguous chunk per worker of the shared thread
+// pool and calls the function on every chunk in parallel
+template <typename Function>
+void for_each_row_chunk(size_t number_of_rows, Function function) {
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_threads = pool.get_number_of_threads();
+	const size_t chunk_size = number_of_rows / number_of_threads;
+
+	pool.run(number_of_threads, [&](size_t thread_index) {
+		size_t start_row = thread_index * chunk_size;
+		// Ensure we do not exceed matrix bounds
+		size_t end_row = (thread_index == number_of_threads - 1)
+							 ? number_of_rows
+							 : start_row + chunk_size;
+		function(start_row, end_row, thread_index);
+	});
+}
+
+// Size of a cache line, which two workers should not write at the same time
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/*
+ * Splits the columns of row-major rows into one chunk per worker of the
+ * shared thread pool, each a whole number of cache lines wide, and calls the
+ * function on every chunk in parallel. Chunks of a few values would put
+ * several workers on the same cache line of every row, so when there are
+ * fewer cache lines than workers, fewer workers are used, down to running on
+ * the calling thread alone.
+ */
+template <typename T, typename Function>
+void for_each_column_chunk(size_t number_of_columns, Function function) {
+	constexpr size_t values_per_line =
+		std::max<size_t>(CACHE_LINE_SIZE / sizeof(T), 1);
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_lines =
+		(number_of_columns + values_per_line - 1) / values_per_line;
+	const size_t number_of_chunks =
+		std::min(pool.get_number_of_threads(), number_of_lines);
+	if (number_of_chunks <= 1) {
+		function(0, number_of_columns, 0);
+		return;
+	}
+
+	const size_t chunk_size =
+		(number_of_lines + number_of_chunks - 1) / number_of_chunks *
+		values_per_line;
+	pool.run(number_of_chunks, [&](size_t chunk_index) {
+		const size_t start_column =
+			std::min(chunk_index * chunk_size, number_of_columns);
+		const size_t end_column =
+			std::min(start_column + chunk_size, number_of_columns);
+		function(start_column, end_column, chunk_index);
+	});
+}
+
+// Rows are owned by the workers in blocks of at least this many rows
+constexpr size_t OWNED_ROW_BLOCK_SIZE = 8;
+
+// Whether the workers of the shared thread pool are spread over several NUMA
+// nodes, in which case the blocks of rows are placed on their owners' nodes
+inline bool is_shared_pool_on_multiple_nodes() {
+	ThreadPool &pool = ThreadPool::shared();
+	for (size_t i = 1; i < pool.get_number_of_threads(); ++i) {
+		if (pool.get_worker_node(i) != pool.get_worker_node(0)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Get the number of rows of the owned blocks of a matrix with rows of the
+ * given length. Only whole pages can be placed on a node, so with several
+ * nodes the blocks are rounded up to a multiple of the page size. When the
+ * rows only add up to whole pages in very large blocks, which would leave
+ * workers without rows, the blocks span at least two pages instead, so that
+ * only the pages they share at their edges end up on another node.
+ */
+template <typename T>
+size_t get_owned_row_block_size(size_t number_of_columns) {
+	static const bool multiple_nodes = is_shared_pool_on_multiple_nodes();
+	const size_t row_size = number_of_columns * sizeof(T);
+	if (!multiple_nodes || row_size == 0) {
+		return OWNED_ROW_BLOCK_SIZE;
+	}
+
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	const size_t rows_per_page_multiple =
+		page_size / std::gcd(page_size, row_size);
+	if (rows_per_page_multiple <= 8 * OWNED_ROW_BLOCK_SIZE) {
+		return (OWNED_ROW_BLOCK_SIZE + rows_per_page_multiple - 1) /
+			   rows_per_page_multiple * rows_per_page_multiple;
+	}
+	return std::max(
+		OWNED_ROW_BLOCK_SIZE, (2 * page_size + row_size - 1) / row_size
+	);
+}
+
+/*
+ * Deals the blocks of rows out to the workers of the shared thread pool like
+ * cards, so block b is always owned by worker b modulo the number of workers.
+ * Unlike with for_each_row_chunk, the owner of a row does not change when the
+ * range shrinks from step to step of an elimination, and the remaining rows
+ * stay spread evenly over the workers. The function is called for every part
+ * of a block within [start_row, end_row) on the worker owning it.
+ */
+template <typename Function>
+void for_each_owned_row_block(
+	size_t start_row,
+	size_t end_row,
+	Function function,
+	size_t block_size = OWNED_ROW_BLOCK_SIZE
+) {
+	if (start_row >= end_row) {
+		return;
+	}
+
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_threads = pool.get_number_of_threads();
+	const size_t first_block = start_row / block_size;
+
+	pool.run(number_of_threads, [&](size_t thread_index) {
+		// The first block of this worker at or after the first block
+		size_t block = first_block +
+					   (thread_index + number_of_threads -
+						first_block % number_of_threads) %
+						   number_of_threads;
+		for (; block * block_size < end_row; block += number_of_threads) {
+			function(
+				std::max(block * block_size, start_row),
+				std::min((block + 1) * block_size, end_row),
+				thread_index
+			);
+		}
+	});
+}
+
+// Moves every block of rows to the NUMA node of the worker owning it, see
+// for_each_owned_row_block. Does nothing on machines with a single node.
+template <typename T>
+void place_owned_row_blocks(
+	T *data,
+	size_t number_of_rows,
+	size_t number_of_columns,
+	size_t block_size = OWNED_ROW_BLOCK_SIZE
+) {
+	if (!is_shared_pool_on_multiple_nodes()) {
+		return;
+	}
+
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_threads = pool.get_number_of_threads();
+	const size_t block_length = block_size * number_of_columns;
+	for (size_t block = 0; block * block_size < number_of_rows; ++block) {
+		const size_t block_rows =
+			std::min(block_size, number_of_rows - block * block_size);
+		bind_memory_to_node(
+			data + block * block_length,
+			block_rows * number_of_columns * sizeof(T),
+			pool.get_worker_node(block % number_of_threads)
+		);
+	}
+}
+
+// The product of two matrices, evaluated one row of the result at a time
+template <typename T> class MatrixProduct : public MatrixExpressionBase {
+	private:
+	const Matrix<T> &lhs;
+	const Matrix<T> &rhs;
+
+	public:
+	using value_type = T;
+
+	MatrixProduct(const Matrix<T> &lhs, const Matrix<T> &rhs)
+		: lhs(lhs), rhs(rhs) {
+		// Matrix A is R^t -> R^r and Matrix B is R^c -> R^p but we cannot
+		// compose R^c -> R^p and R^t -> R^r since p != t
+		if (lhs.get_number_of_columns() != rhs.get_number_of_rows()) {
+			std::stringstream error_message;
+			error_message << "Cannot compose R^" << lhs.get_number_of_columns()
+						  << " -> R^" << lhs.get_number_of_rows() << " with R^"
+						  << rhs.get_number_of_columns() << "R^"
+						  << rhs.get_number_of_rows() << "!";
+			throw std::runtime_error(error_message.str());
+		}
+	}
+
+	// Matrix A is R^t -> R^r and Matrix B is R^c -> R^t. So when we compose
+	// R^c -> R^t and R^t -> R^r, we get R^c -> R^r
+	size_t get_number_of_rows() const { return this->lhs.get_number_of_rows(); }
+
+	size_t get_number_of_columns() const {
+		return this->rhs.get_number_of_columns();
+	}
+
+	// The row of the product is a combination of the rows of the right hand
+	// side, which keeps the innermost loop on contiguous memory
+	void accumulate_row(size_t row, T *target, T factor) const {
+		for (size_t i = 0; i < this->lhs.get_number_of_columns(); ++i) {
+			this->rhs.accumulate_row(i, target, factor * this->lhs.at(row, i));
+		}
+	}
+};
+
+// The sum of two expressions of the same size
+template <typename L, typename R> class MatrixSum : public MatrixExpressionBase {
+	private:
+	expression_storage_t<L> lhs;
+	expression_storage_t<R> rhs;
+
+	public:
+	using value_type = typename L::value_type;
+
+	MatrixSum(const L &lhs, const R &rhs) : lhs(lhs), rhs(rhs) {
+		if (lhs.get_number_of_rows() != rhs.get_number_of_rows() ||
+			lhs.get_number_of_columns() != rhs.get_number_of_columns()) {
+			throw std::runtime_error("Cannot add matrices of different sizes!");
+		}
+	}
+
+	size_t get_number_of_rows() const { return this->lhs.get_number_of_rows(); }
+
+	size_t get_number_of_columns() const {
+		return this->lhs.get_number_of_columns();
+	}
+
+	void accumulate_row(size_t row, value_type *target, value_type factor)
+		const {
+		this->lhs.accumulate_row(row, target, factor);
+		this->rhs.accumulate_row(row, target, factor);
+	}
+};
+
+template <
+	typename L,
+	typename R,
+	typename = std::enable_if_t<
+		is_matrix_expression_v<L> && is_matrix_expression_v<R>>>
+MatrixSum<L, R> operator+(const L &lhs, const R &rhs) {
+	return MatrixSum<L, R>(lhs, rhs);
+}
+
+// The difference of two expressions of the same size
+template <typename L, typename R>
+class MatrixDifference : public MatrixExpressionBase {
+	private:
+	expression_storage_t<L> lhs;
+	expression_storage_t<R> rhs;
+
+	public:
+	using value_type = typename L::value_type;
+
+	MatrixDifference(const L &lhs, const R &rhs) : lhs(lhs), rhs(rhs) {
+		if (lhs.get_number_of_rows() != rhs.get_number_of_rows() ||
+			lhs.get_number_of_columns() != rhs.get_number_of_columns()) {
+			throw std::runtime_error(
+				"Cannot subtract matrices of different sizes!"
+			);
+		}
+	}
+
+	size_t get_number_of_rows() const { return this->lhs.get_number_of_rows(); }
+
+	size_t get_number_of_columns() const {
+		return this->lhs.get_number_of_columns();
+	}
+
+	void accumulate_row(size_t row, value_type *target, value_type factor)
+		const {
+		this->lhs.accumulate_row(row, target, factor);
+		this->rhs.accumulate_row(row, target, -factor);
+	}
+};
+
+template <
+	typename L,
+	typename R,
+	typename = std::enable_if_t<
+		is_matrix_expression_v<L> && is_matrix_expression_v<R>>>
+MatrixDifference<L, R> operator-(const L &lhs, const R &rhs) {
+	return MatrixDifference<L, R>(lhs, rhs);
+}
+
+/*
+ * The Frobenius norm of an expression, evaluated in a single parallel pass.
+ * Every thread evaluates one row at a time into a buffer and the sum of
+ * squares is kept scaled by the largest value seen so far, like in LAPACK's
+ * nrm2, so that it neither overflows nor underflows.
+ */
+template <
+	typename E,
+	typename = std::enable_if_t<is_matrix_expression_v<E>>>
+const double abs(const E &expression) {
+	using T = typename E::value_type;
+
+	const size_t number_of_threads =
+		ThreadPool::shared().get_number_of_threads();
+	std::vector<double> scales(number_of_threads, 0);
+	std::vector<double> sums_of_squares(number_of_threads, 1);
+
+	for_each_row_chunk(
+		expression.get_number_of_rows(),
+		[&](size_t start_row, size_t end_row, size_t thread_index) {
+			std::pmr::vector<T> row_values(expression.get_number_of_columns());
+			double &scale = scales[thread_index];
+			double &sum_of_squares = sums_of_squares[thread_index];
+
+			for (size_t row = start_row; row < end_row; ++row) {
+				std::fill(row_values.begin(), row_values.end(), 0);
+				expression.accumulate_row(row, row_values.data(), 1);
+
+				double row_scale = 0;
+				for (const T &value : row_values) {
+					double absolute_value = std::abs(double(value));
+					// Written so that a NaN sticks once it has been seen
+					if (absolute_value > row_scale ||
+						absolute_value != absolute_value) {
+						row_scale = absolute_value;
+					}
+				}
+				if (row_scale == 0) {
+					continue;
+				}
+				if (!std::isfinite(row_scale)) {
+					// Infinities and NaNs propagate to the result
+					if (!std::isnan(scale)) {
+						scale = row_scale;
+					}
+					continue;
+				}
+
+				const double inverse_row_scale = 1 / row_scale;
+				double row_sum_of_squares = 0;
+				for (const T &value : row_values) {
+					double scaled_value = value * inverse_row_scale;
+					row_sum_of_squares += scaled_value * scaled_value;
+				}
+
+				if (row_scale > scale) {
+					sum_of_squares =
+						row_sum_of_squares +
+						sum_of_squares * pow(scale / row_scale, 2);
+					scale = row_scale;
+				} else {
+					sum_of_squares +=
+						row_sum_of_squares * pow(row_scale / scale, 2);
+				}
+			}
+		}
+	);
+
+	double scale = 0;
+	double sum_of_squares = 1;
+	for (size_t thread_index = 0; thread_index < number_of_threads;
+		 ++thread_index) {
+		const double chunk_scale = scales[thread_index];
+		if (chunk_scale == 0) {
+			continue;
+		}
+		// Rescaling by an infinite scale would divide infinity by infinity,
+		// so infinities and NaNs are propagated like within a chunk
+		if (!std::isfinite(chunk_scale)) {
+			if (!std::isnan(scale)) {
+				scale = chunk_scale;
+			}
+			continue;
+		}
+		if (chunk_scale > scale) {
+			sum_of_squares = sums_of_squares[thread_index] +
+							 sum_of_squares * pow(scale / chunk_scale, 2);
+			scale = chunk_scale;
+		} else {
+			sum_of_squares +=
+				sums_of_squares[thread_index] * pow(chunk_scale / scale, 2);
+		}
+	}
+
+	return scale * sqrt(sum_of_squares);
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include "matrix_expression.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef MATRIX_FILE_H
+#define MATRIX_FILE_H
+
+// Binary matrix files start with this, followed by the number of rows and of
+// columns as 64-bit integers and the values row by row, all in the native
+// byte order. A text file cannot start with it, so the two are told apart by
+// the first bytes.
+constexpr char BINARY_MATRIX_MAGIC[8] = {'G', 'E', 'M', 'B', 'I', 'N', '1', 0};
+
+/*
+ * Writes a matrix to a file a few rows at a time, so that it never has to be
+ * held in memory as a whole. Text files have the same format as the ones
+ * written by Matrix::save_to_file, the rows are formatted in parallel.
+ */
+class MatrixFileWriter {
+	private:
+	std::ofstream file;
+	bool binary;
+	size_t number_of_rows;
+	size_t number_of_columns;
+	size_t rows_written = 0;
+
+	public:
+	MatrixFileWriter(
+		const std::string &path,
+		size_t number_of_rows,
+		size_t number_of_columns,
+		bool binary = false
+	)
+		: file(path, std::ios::binary), binary(binary),
+		  number_of_rows(number_of_rows), number_of_columns(number_of_columns) {
+		if (!this->file) {
+			throw std::runtime_error("Could not open " + path);
+		}
+		if (binary) {
+			const uint64_t shape[2] = {number_of_rows, number_of_columns};
+			this->file.write(BINARY_MATRIX_MAGIC, sizeof(BINARY_MATRIX_MAGIC));
+			this->file.write(
+				reinterpret_cast<const char *>(shape), sizeof(shape)
+			);
+		}
+	}
+
+	// Write the next rows, given row by row
+	template <typename T> void write_rows(const T *values, size_t count) {
+		if (this->rows_written + count > this->number_of_rows) {
+			throw std::runtime_error("Too many rows written to the file!");
+		}
+
+		if (this->binary) {
+			this->file.write(
+				reinterpret_cast<const char *>(values),
+				count * this->number_of_columns * sizeof(T)
+			);
+		} else {
+			std::vector<std::string> lines(count);
+			for_each_row_chunk(
+				count, [&](size_t start_row, size_t end_row, size_t) {
+					std::stringstream line;
+					for (size_t row = start_row; row < end_row; ++row) {
+						line.str("");
+						for (size_t column = 0;
+							 column < this->number_of_columns;
+							 ++column) {
+							line << values[row * this->number_of_columns +
+										   column];
+							if (column < this->number_of_columns - 1) {
+								line << " ";
+							}
+						}
+						lines[row] = line.str();
+					}
+				}
+			);
+			for (size_t row = 0; row < count; ++row) {
+				if (this->rows_written + row > 0) {
+					this->file << "\n";
+				}
+				this->file << lines[row];
+			}
+		}
+
+		this->rows_written += count;
+		if (!this->file) {
+			throw std::runtime_error("Could not write to the matrix file!");
+		}
+	}
+};
+
+// Checks whether the stream is at the start of a binary matrix file, leaving
+// it where it was otherwise
+inline bool read_binary_matrix_magic(std::istream &stream) {
+	char magic[sizeof(BINARY_MATRIX_MAGIC)] = {};
+	stream.read(magic, sizeof(magic));
+	if (stream.gcount() == sizeof(magic) &&
+		std::memcmp(magic, BINARY_MATRIX_MAGIC, sizeof(magic)) == 0) {
+		return true;
+	}
+	stream.clear();
+	stream.seekg(0);
+	return false;
+}
+
+// Reads the shape following the magic of a binary matrix file and checks that
+// the rest of the stream holds that many values, so that a corrupt header
+// cannot make the reader allocate more than the file contains
+inline void read_binary_matrix_shape(
+	std::istream &stream, uint64_t shape[2], size_t value_size
+) {
+	stream.read(reinterpret_cast<char *>(shape), 2 * sizeof(uint64_t));
+	if (!stream) {
+		throw std::runtime_error("The binary matrix file is truncated!");
+	}
+
+	const std::streampos data_start = stream.tellg();
+	stream.seekg(0, std::ios::end);
+	const uint64_t remaining_bytes = stream.tellg() - data_start;
+	stream.seekg(data_start);
+
+	const uint64_t remaining_values = remaining_bytes / value_size;
+	if (shape[0] != 0 && shape[1] > remaining_values / shape[0]) {
+		throw std::runtime_error("The binary matrix file is truncated!");
+	}
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include "matrix.hpp"
+#include "matrix_expression.hpp"
+#include "matrix_file.hpp"
+#include "philox.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+
+#ifndef MATRIX_GENERATOR_H
+#define MATRIX_GENERATOR_H
+
+// Roughly how many bytes of rows are generated at once when streaming to a
+// file
+constexpr size_t GENERATION_BLOCK_SIZE = 4 << 20;
+
+/*
+ * A family of matrices given by how to generate any single row. Random values
+ * come from Philox and only depend on the seed and their position, so rows
+ * can be generated in any order and in parallel and the result is the same
+ * for any number of threads.
+ */
+template <typename T> class MatrixGenerator {
+	private:
+	size_t number_of_rows;
+	size_t number_of_columns;
+	std::function<void(size_t, T *)> generate_row;
+
+	MatrixGenerator(
+		size_t number_of_rows,
+		size_t number_of_columns,
+		std::function<void(size_t, T *)> generate_row
+	)
+		: number_of_rows(number_of_rows), number_of_columns(number_of_columns),
+		  generate_row(std::move(generate_row)) {}
+
+	// Makes the diagonal larger than the sum of the absolute values of the
+	// rest of the row, given a row with a zero on the diagonal
+	static void make_diagonally_dominant(size_t row, T *values, size_t size) {
+		T sum = 1;
+		for (size_t column = 0; column < size; ++column) {
+			sum += std::abs(values[column]);
+		}
+		values[row] = sum;
+	}
+
+	public:
+	// The same values as Matrix::random with the same seed
+	static MatrixGenerator<T> random(
+		size_t number_of_rows,
+		size_t number_of_columns,
+		T min,
+		T max,
+		uint64_t seed
+	) {
+		return MatrixGenerator<T>(
+			number_of_rows,
+			number_of_columns,
+			[=](size_t row, T *values) {
+				for (size_t column = 0; column < number_of_columns; ++column) {
+					values[column] = philox_uniform(
+						seed, row * number_of_columns + column, min, max
+					);
+				}
+			}
+		);
+	}
+
+	static MatrixGenerator<T>
+	ones(size_t number_of_rows, size_t number_of_columns) {
+		return MatrixGenerator<T>(
+			number_of_rows,
+			number_of_columns,
+			[=](size_t, T *values) {
+				std::fill(values, values + number_of_columns, 1);
+			}
+		);
+	}
+
+	static MatrixGenerator<T> identity(size_t size) {
+		return MatrixGenerator<T>(size, size, [=](size_t row, T *values) {
+			std::fill(values, values + size, 0);
+			values[row] = 1;
+		});
+	}
+
+	static MatrixGenerator<T> hilbert(size_t size) {
+		return MatrixGenerator<T>(size, size, [=](size_t row, T *values) {
+			for (size_t column = 0; column < size; ++column) {
+				values[column] = 1.0 / (row + column + 1.0);
+			}
+		});
+	}
+
+	// Random values off the diagonal and a diagonal that is larger than the
+	// rest of its row, so the matrix is regular and needs no pivoting
+	static MatrixGenerator<T>
+	diagonally_dominant(size_t size, T min, T max, uint64_t seed) {
+		return MatrixGenerator<T>(size, size, [=](size_t row, T *values) {
+			for (size_t column = 0; column < size; ++column) {
+				values[column] =
+					column == row
+						? 0
+						: philox_uniform(seed, row * size + column, min, max);
+			}
+			make_diagonally_dominant(row, values, size);
+		});
+	}
+
+	// A symmetric diagonally dominant matrix with a positive diagonal, which
+	// is positive definite. Both halves take the value of the upper one.
+	static MatrixGenerator<T>
+	symmetric_positive_definite(size_t size, T min, T max, uint64_t seed) {
+		return MatrixGenerator<T>(size, size, [=](size_t row, T *values) {
+			for (size_t column = 0; column < size; ++column) {
+				size_t upper_row = std::min(row, column);
+				size_t upper_column = std::max(row, column);
+				values[column] = column == row ? 0
+											   : philox_uniform(
+													 seed,
+													 upper_row * size +
+														 upper_column,
+													 min,
+													 max
+												 );
+			}
+			make_diagonally_dominant(row, values, size);
+		});
+	}
+
+	// Random values within the given distance from the diagonal and zeros
+	// everywhere else
+	static MatrixGenerator<T>
+	banded(size_t size, size_t bandwidth, T min, T max, uint64_t seed) {
+		return MatrixGenerator<T>(size, size, [=](size_t row, T *values) {
+			std::fill(values, values + size, 0);
+			size_t start_column = row > bandwidth ? row - bandwidth : 0;
+			size_t end_column = std::min(row + bandwidth + 1, size);
+			for (size_t column = start_column; column < end_column; ++column) {
+				values[column] =
+					philox_uniform(seed, row * size + column, min, max);
+			}
+		});
+	}
+
+	size_t get_number_of_rows() const { return this->number_of_rows; }
+
+	size_t get_number_of_columns() const { return this->number_of_columns; }
+
+	// Generate the whole matrix in memory
+	Matrix<T> generate() const {
+		MatrixStorage<T> data(this->number_of_rows * this->number_of_columns);
+		for_each_row_chunk(
+			this->number_of_rows,
+			[this, &data](size_t start_row, size_t end_row, size_t) {
+				for (size_t row = start_row; row < end_row; ++row) {
+					this->generate_row(
+						row, &data[row * this->number_of_columns]
+					);
+				}
+			}
+		);
+		return Matrix<T>(
+			std::move(data), this->number_of_rows, this->number_of_columns
+		);
+	}
+
+	// Generate the matrix straight into a file, holding only a block of rows
+	// in memory at a time
+	void write_to_file(const std::string &path, bool binary = false) const {
+		MatrixFileWriter writer(
+			path, this->number_of_rows, this->number_of_columns, binary
+		);
+
+		const size_t block_rows = std::max<size_t>(
+			GENERATION_BLOCK_SIZE /
+				std::max<size_t>(this->number_of_columns * sizeof(T), 1),
+			1
+		);
+		std::pmr::vector<T> block(block_rows * this->number_of_columns);
+		for (size_t block_start = 0; block_start < this->number_of_rows;
+			 block_start += block_rows) {
+			const size_t count =
+				std::min(block_rows, this->number_of_rows - block_start);
+			for_each_row_chunk(
+				count, [&](size_t start_row, size_t end_row, size_t) {
+					for (size_t row = start_row; row < end_row; ++row) {
+						this->generate_row(
+							block_start + row,
+							&block[row * this->number_of_columns]
+						);
+					}
+				}
+			);
+			writer.write_rows(block.data(), count);
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef NUMA_H
+#define NUMA_H
+
+// From linux/mempolicy.h, which is not always installed
+constexpr int NUMA_POLICY_PREFERRED = 1;
+constexpr unsigned NUMA_MOVE_PAGES = 1 << 1;
+
+struct NumaNode {
+	int id;
+	std::vector<int> cpus;
+};
+
+// Parses a CPU list like "0-3,8-11" as found in /sys
+inline std::vector<int> parse_cpu_list(const std::string &cpu_list) {
+	std::vector<int> cpus;
+	std::stringstream stream(cpu_list);
+	std::string range;
+	while (std::getline(stream, range, ',')) {
+		if (range.empty() || range == "\n") {
+			continue;
+		}
+		size_t separator = range.find('-');
+		int first = std::stoi(range.substr(0, separator));
+		int last = separator == std::string::npos
+					   ? first
+					   : std::stoi(range.substr(separator + 1));
+		for (int cpu = first; cpu <= last; ++cpu) {
+			cpus.push_back(cpu);
+		}
+	}
+	return cpus;
+}
+
+/*
+ * The NUMA nodes of the machine with the CPUs this process may run on. It is
+ * read from /sys, so it needs neither libnuma nor a NUMA enabled kernel; when
+ * there is nothing to read, all CPUs form a single node.
+ */
+class NumaTopology {
+	private:
+	std::vector<NumaNode> nodes;
+
+	public:
+	static NumaTopology detect() {
+		cpu_set_t allowed_cpus;
+		CPU_ZERO(&allowed_cpus);
+		bool affinity_known =
+			sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus) == 0;
+		auto is_allowed = [&](int cpu) {
+			return !affinity_known ||
+				   (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed_cpus));
+		};
+
+		NumaTopology topology;
+		const std::filesystem::path node_directory = "/sys/devices/system/node";
+		std::error_code error;
+		for (int id = 0; std::filesystem::exists(
+				 node_directory / ("node" + std::to_string(id)), error
+			 );
+			 ++id) {
+			std::ifstream file(
+				node_directory / ("node" + std::to_string(id)) / "cpulist"
+			);
+			std::string cpu_list;
+			std::getline(file, cpu_list);
+
+			NumaNode node{id, {}};
+			for (int cpu : parse_cpu_list(cpu_list)) {
+				if (is_allowed(cpu)) {
+					node.cpus.push_back(cpu);
+				}
+			}
+			// Nodes with memory only or no allowed CPUs get no workers
+			if (!node.cpus.empty()) {
+				topology.nodes.push_back(node);
+			}
+		}
+
+		if (topology.nodes.empty()) {
+			NumaNode node{0, {}};
+			for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+				if (affinity_known ? bool(CPU_ISSET(cpu, &allowed_cpus))
+								   : cpu < int(std::thread::hardware_concurrency(
+									 ))) {
+					node.cpus.push_back(cpu);
+				}
+			}
+			topology.nodes.push_back(node);
+		}
+		return topology;
+	}
+
+	const std::vector<NumaNode> &get_nodes() const { return this->nodes; }
+
+	size_t get_number_of_cpus() const {
+		size_t number_of_cpus = 0;
+		for (const auto &node : this->nodes) {
+			number_of_cpus += node.cpus.size();
+		}
+		return number_of_cpus;
+	}
+};
+
+// Asks the kernel to keep the pages of the range on the given node, moving the
+// ones that are already there. Returns false where that is not possible, e.g.
+// without a NUMA enabled kernel, in which case the pages stay where they are.
+inline bool bind_memory_to_node(void *start, size_t length, int node) {
+#ifdef SYS_mbind
+	constexpr size_t bits_per_word = sizeof(unsigned long) * 8;
+	unsigned long node_mask[16] = {};
+	if (node < 0 || size_t(node) >= sizeof(node_mask) * 8) {
+		return false;
+	}
+	node_mask[node / bits_per_word] |= 1UL << (node % bits_per_word);
+
+	// Only whole pages can be bound
+	const size_t page_size = sysconf(_SC_PAGESIZE);
+	size_t first_page =
+		(reinterpret_cast<size_t>(start) + page_size - 1) / page_size;
+	size_t end_page = (reinterpret_cast<size_t>(start) + length) / page_size;
+	if (end_page <= first_page) {
+		return true;
+	}
+
+	return syscall(
+			   SYS_mbind,
+			   first_page * page_size,
+			   (end_page - first_page) * page_size,
+			   NUMA_POLICY_PREFERRED,
+			   node_mask,
+			   sizeof(node_mask) * 8,
+			   NUMA_MOVE_PAGES
+		   ) == 0;
+#else
+	return false;
+#endif
+}
+
+#endif
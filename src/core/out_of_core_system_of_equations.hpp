@@ -0,0 +1,574 @@
+#include "matrix.hpp"
+#include "matrix_expression.hpp"
+#include "matrix_file.hpp"
+#include "triangular_solve.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifndef OUT_OF_CORE_SYSTEM_OF_EQUATIONS_H
+#define OUT_OF_CORE_SYSTEM_OF_EQUATIONS_H
+
+// Number of panel sized buffers the factorization keeps in memory: the panel
+// being factored, the one being prefetched after it, the panel of L being
+// applied and the one being prefetched after that
+constexpr size_t OUT_OF_CORE_BUFFERS = 4;
+
+/*
+ * A square matrix stored in a temporary binary file as column panels. Each
+ * panel spans all rows and panel_width columns (the last one possibly fewer)
+ * and is stored row by row, i.e. as a stack of panel_width x panel_width
+ * tiles, so that a whole panel is read or written with a single request.
+ */
+template <typename T> class TiledMatrixFile {
+	private:
+	std::string path;
+	int file_descriptor;
+	size_t size;
+	size_t panel_width;
+
+	off_t get_offset(size_t panel, size_t row) const {
+		return (panel * this->panel_width * this->size +
+				row * this->get_panel_columns(panel)) *
+			   sizeof(T);
+	}
+
+	public:
+	TiledMatrixFile(
+		size_t size, size_t panel_width, const std::filesystem::path &directory
+	)
+		: size(size), panel_width(panel_width) {
+		std::string path_template = (directory / "gem-tiles-XXXXXX").string();
+		this->file_descriptor = mkstemp(path_template.data());
+		if (this->file_descriptor == -1) {
+			throw std::runtime_error(
+				"Could not create a tile file in " + directory.string()
+			);
+		}
+		this->path = path_template;
+	}
+
+	TiledMatrixFile(const TiledMatrixFile<T> &) = delete;
+	TiledMatrixFile<T> &operator=(const TiledMatrixFile<T> &) = delete;
+
+	~TiledMatrixFile() {
+		close(this->file_descriptor);
+		unlink(this->path.c_str());
+	}
+
+	size_t get_number_of_panels() const {
+		return (this->size + this->panel_width - 1) / this->panel_width;
+	}
+
+	size_t get_panel_width() const { return this->panel_width; }
+
+	// Get the number of columns of a panel, which is only smaller than the
+	// panel width for the last one
+	size_t get_panel_columns(size_t panel) const {
+		return std::min(
+			this->panel_width, this->size - panel * this->panel_width
+		);
+	}
+
+	// Read consecutive rows of a panel. This may be called from several
+	// threads at once.
+	void read_rows(
+		size_t panel, size_t start_row, size_t number_of_rows, T *buffer
+	) const {
+		char *target = reinterpret_cast<char *>(buffer);
+		size_t remaining =
+			number_of_rows * this->get_panel_columns(panel) * sizeof(T);
+		off_t offset = this->get_offset(panel, start_row);
+
+		while (remaining > 0) {
+			ssize_t read =
+				pread(this->file_descriptor, target, remaining, offset);
+			if (read <= 0) {
+				throw std::runtime_error("Could not read from the tile file!");
+			}
+			target += read;
+			remaining -= read;
+			offset += read;
+		}
+	}
+
+	// Read the whole panel into a buffer of size x panel columns values
+	void read_panel(size_t panel, T *buffer) const {
+		this->read_rows(panel, 0, this->size, buffer);
+	}
+
+	// Write consecutive rows of a panel
+	void write_rows(
+		size_t panel, size_t start_row, size_t number_of_rows, const T *buffer
+	) {
+		const char *source = reinterpret_cast<const char *>(buffer);
+		size_t remaining =
+			number_of_rows * this->get_panel_columns(panel) * sizeof(T);
+		off_t offset = this->get_offset(panel, start_row);
+
+		while (remaining > 0) {
+			ssize_t written =
+				pwrite(this->file_descriptor, source, remaining, offset);
+			if (written <= 0) {
+				throw std::runtime_error("Could not write to the tile file!");
+			}
+			source += written;
+			remaining -= written;
+			offset += written;
+		}
+	}
+
+	void write_panel(size_t panel, const T *buffer) {
+		this->write_rows(panel, 0, this->size, buffer);
+	}
+};
+
+// Streams a matrix file into a tile file, holding at most panel_width rows in
+// memory at a time
+template <typename T>
+void load_tiled_matrix(
+	const std::string &file_path, size_t size, TiledMatrixFile<T> &tiles
+) {
+	std::ifstream file(file_path, std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Could not open the matrix file!");
+	}
+
+	const size_t block_height = tiles.get_panel_columns(0);
+	std::vector<T> block(block_height * size);
+	size_t number_of_rows = 0;
+
+	// Scatters the buffered rows into the panels they belong to
+	auto flush_block = [&](size_t number_of_block_rows) {
+		const size_t start_row = number_of_rows - number_of_block_rows;
+		std::vector<T> panel_rows;
+		for (size_t panel = 0; panel < tiles.get_number_of_panels(); ++panel) {
+			const size_t panel_columns = tiles.get_panel_columns(panel);
+			const size_t start_column = panel * block_height;
+			panel_rows.resize(number_of_block_rows * panel_columns);
+			for (size_t row = 0; row < number_of_block_rows; ++row) {
+				std::copy_n(
+					&block[row * size + start_column],
+					panel_columns,
+					&panel_rows[row * panel_columns]
+				);
+			}
+			tiles.write_rows(
+				panel, start_row, number_of_block_rows, panel_rows.data()
+			);
+		}
+	};
+
+	if (read_binary_matrix_magic(file)) {
+		uint64_t shape[2];
+		file.read(reinterpret_cast<char *>(shape), sizeof(shape));
+		if (!file || shape[0] != size || shape[1] != size) {
+			throw std::runtime_error(
+				"The matrix does not match the right side!"
+			);
+		}
+		while (number_of_rows < size) {
+			const size_t count = std::min(block_height, size - number_of_rows);
+			file.read(
+				reinterpret_cast<char *>(block.data()), count * size * sizeof(T)
+			);
+			if (!file) {
+				throw std::runtime_error("The binary matrix file is truncated!");
+			}
+			number_of_rows += count;
+			flush_block(count);
+		}
+		return;
+	}
+
+	std::string line;
+	size_t block_row = 0;
+	while (std::getline(file, line)) {
+		std::stringstream line_stream(line);
+
+		size_t row_length = 0;
+		T value;
+		while (line_stream >> value) {
+			if (row_length == size || number_of_rows == size) {
+				throw std::runtime_error(
+					"The matrix does not match the right side!"
+				);
+			}
+			block[block_row * size + row_length] = value;
+			++row_length;
+		}
+		if (row_length == 0) {
+			continue;
+		}
+		if (row_length != size) {
+			throw std::runtime_error(
+				"Row lengths do not match in matrix file!"
+			);
+		}
+
+		++number_of_rows;
+		++block_row;
+		if (block_row == block_height) {
+			flush_block(block_row);
+			block_row = 0;
+		}
+	}
+
+	if (block_row != 0) {
+		flush_block(block_row);
+	}
+	if (number_of_rows != size) {
+		throw std::runtime_error("The matrix does not match the right side!");
+	}
+}
+
+// Applies the row interchanges of the given range of steps to a buffer of rows
+// of the given width
+template <typename T>
+void apply_interchanges(
+	const std::vector<size_t> &pivots,
+	size_t start,
+	size_t end,
+	T *rows,
+	size_t width
+) {
+	for (size_t row = start; row < end; ++row) {
+		if (pivots[row] != row) {
+			std::swap_ranges(
+				rows + row * width,
+				rows + (row + 1) * width,
+				rows + pivots[row] * width
+			);
+		}
+	}
+}
+
+// Subtracts L * U from the given rows of a panel, where L are the values of
+// the panel of L in the columns of the block and U the rows of the block
+template <typename T>
+void update_rows(
+	const T *left,
+	size_t block_start,
+	size_t block_width,
+	T *current,
+	size_t width,
+	size_t start_row,
+	size_t end_row
+) {
+	for (size_t row = start_row; row < end_row; ++row) {
+		T *target = current + row * width;
+		for (size_t i = 0; i < block_width && block_start + i < row; ++i) {
+			const T multiplicator = left[row * block_width + i];
+			const T *source = current + (block_start + i) * width;
+			for (size_t column = 0; column < width; ++column) {
+				target[column] -= multiplicator * source[column];
+			}
+		}
+	}
+}
+
+// Runs the function on chunks of the rows [start_row, end_row), in parallel if
+// requested
+template <typename Function>
+void for_each_row_range(
+	size_t start_row, size_t end_row, bool parallel, Function function
+) {
+	if (!parallel) {
+		function(start_row, end_row);
+		return;
+	}
+
+	for_each_row_chunk(
+		end_row - start_row,
+		[start_row, &function](size_t chunk_start, size_t chunk_end, size_t) {
+			function(start_row + chunk_start, start_row + chunk_end);
+		}
+	);
+}
+
+/*
+ * Solves a system whose map is too large to be held in memory. The map is
+ * streamed from its file into a tile file on local disk and factored by a
+ * left-looking blocked LU decomposition with partial pivoting: each panel is
+ * updated by all panels left of it, which are streamed through memory one at
+ * a time while the next one is prefetched, and then factored in memory. The
+ * interchanges of later panels are applied to the panels of L lazily whenever
+ * they are read back. At most memory_limit bytes are used for the panels, the
+ * right side and the pivots.
+ */
+template <typename T>
+Matrix<T> solve_system_of_equations_out_of_core(
+	const std::string &map_file_path,
+	const Matrix<T> &right_side,
+	size_t memory_limit,
+	bool parallel = true,
+	const std::filesystem::path &directory =
+		std::filesystem::temp_directory_path()
+) {
+	const size_t size = right_side.get_number_of_rows();
+	const size_t number_of_right_sides = right_side.get_number_of_columns();
+	if (size == 0) {
+		throw std::runtime_error("Cannot solve an empty system!");
+	}
+
+	// The right side and the solution are kept in memory next to the pivots
+	const size_t reserved_memory =
+		size * (2 * number_of_right_sides * sizeof(T) + sizeof(size_t));
+	if (memory_limit <= reserved_memory) {
+		throw std::runtime_error("The memory limit is too small!");
+	}
+	const size_t panel_width = std::min(
+		size,
+		(memory_limit - reserved_memory) /
+			(OUT_OF_CORE_BUFFERS * size * sizeof(T))
+	);
+	if (panel_width == 0) {
+		throw std::runtime_error("The memory limit is too small!");
+	}
+
+	TiledMatrixFile<T> tiles(size, panel_width, directory);
+	load_tiled_matrix(map_file_path, size, tiles);
+
+	const size_t number_of_panels = tiles.get_number_of_panels();
+	std::vector<size_t> pivots(size);
+	std::vector<T> current(size * panel_width);
+	std::vector<T> next_current(size * panel_width);
+	std::vector<T> left(size * panel_width);
+	std::vector<T> next_left(size * panel_width);
+
+	// The buffers get swapped while reads are in flight, so the reads have to
+	// hold on to the memory rather than to the vectors
+	auto read_panel_async = [&tiles](size_t panel, std::vector<T> &buffer) {
+		return std::async(
+			std::launch::async,
+			[&tiles, panel, target = buffer.data()]() {
+				tiles.read_panel(panel, target);
+			}
+		);
+	};
+
+	std::future<void> current_read = read_panel_async(0, current);
+	for (size_t panel = 0; panel < number_of_panels; ++panel) {
+		const size_t panel_start = panel * panel_width;
+		const size_t width = tiles.get_panel_columns(panel);
+
+		current_read.get();
+		std::future<void> next_current_read;
+		if (panel + 1 < number_of_panels) {
+			next_current_read = read_panel_async(panel + 1, next_current);
+		}
+
+		apply_interchanges(pivots, 0, panel_start, current.data(), width);
+
+		// Update the panel by all panels left of it
+		std::future<void> left_read;
+		if (panel > 0) {
+			left_read = read_panel_async(0, left);
+		}
+		for (size_t block = 0; block < panel; ++block) {
+			const size_t block_start = block * panel_width;
+			const size_t block_end = block_start + panel_width;
+
+			left_read.get();
+			if (block + 1 < panel) {
+				left_read = read_panel_async(block + 1, next_left);
+			}
+			apply_interchanges(
+				pivots, block_end, panel_start, left.data(), panel_width
+			);
+
+			// Rows of the block first, they form the block of U used below
+			update_rows(
+				left.data(),
+				block_start,
+				panel_width,
+				current.data(),
+				width,
+				block_start,
+				block_end
+			);
+			for_each_row_range(
+				block_end,
+				size,
+				parallel,
+				[&](size_t start_row, size_t end_row) {
+					update_rows(
+						left.data(),
+						block_start,
+						panel_width,
+						current.data(),
+						width,
+						start_row,
+						end_row
+					);
+				}
+			);
+
+			std::swap(left, next_left);
+		}
+
+		// Factor the panel in memory
+		for (size_t column = 0; column < width; ++column) {
+			const size_t diagonal = panel_start + column;
+
+			size_t pivot_row = diagonal;
+			for (size_t row = diagonal + 1; row < size; ++row) {
+				if (std::abs(current[row * width + column]) >
+					std::abs(current[pivot_row * width + column])) {
+					pivot_row = row;
+				}
+			}
+			if (current[pivot_row * width + column] == 0) {
+				throw std::runtime_error("The matrix is singular!");
+			}
+
+			pivots[diagonal] = pivot_row;
+			apply_interchanges(
+				pivots, diagonal, diagonal + 1, current.data(), width
+			);
+
+			const T *pivot_values = &current[diagonal * width];
+			for_each_row_range(
+				diagonal + 1,
+				size,
+				parallel && size - diagonal > panel_width,
+				[&](size_t start_row, size_t end_row) {
+					for (size_t row = start_row; row < end_row; ++row) {
+						T *values = &current[row * width];
+						values[column] /= pivot_values[column];
+						for (size_t i = column + 1; i < width; ++i) {
+							values[i] -= values[column] * pivot_values[i];
+						}
+					}
+				}
+			);
+		}
+
+		tiles.write_panel(panel, current.data());
+
+		std::swap(current, next_current);
+		current_read = std::move(next_current_read);
+	}
+
+	std::vector<T> solution(size * number_of_right_sides);
+	for (size_t row = 0; row < size; ++row) {
+		for (size_t column = 0; column < number_of_right_sides; ++column) {
+			solution[row * number_of_right_sides + column] =
+				right_side.at(row, column);
+		}
+	}
+
+	// Forward substitution with L, streaming the panels left to right
+	apply_interchanges(
+		pivots, 0, size, solution.data(), number_of_right_sides
+	);
+	std::future<void> left_read = read_panel_async(0, left);
+	for (size_t panel = 0; panel < number_of_panels; ++panel) {
+		const size_t panel_start = panel * panel_width;
+		const size_t width = tiles.get_panel_columns(panel);
+
+		left_read.get();
+		if (panel + 1 < number_of_panels) {
+			left_read = read_panel_async(panel + 1, next_left);
+		}
+		apply_interchanges(
+			pivots, panel_start + width, size, left.data(), width
+		);
+
+		update_rows(
+			left.data(),
+			panel_start,
+			width,
+			solution.data(),
+			number_of_right_sides,
+			panel_start,
+			size
+		);
+
+		std::swap(left, next_left);
+	}
+
+	// Backward substitution with U, streaming the rows of U from the bottom up
+	// as blocks of the height of a panel. A block is read as its tiles in the
+	// panels from the diagonal one on, which fit in a panel sized buffer.
+	auto read_row_block_async = [&tiles](size_t panel, std::vector<T> &buffer) {
+		return std::async(
+			std::launch::async,
+			[&tiles, panel, target = buffer.data()]() {
+				const size_t panel_start = panel * tiles.get_panel_width();
+				const size_t height = tiles.get_panel_columns(panel);
+				T *tile = target;
+				for (size_t other = panel; other < tiles.get_number_of_panels();
+					 ++other) {
+					tiles.read_rows(other, panel_start, height, tile);
+					tile += height * tiles.get_panel_columns(other);
+				}
+			}
+		);
+	};
+
+	left_read = read_row_block_async(number_of_panels - 1, left);
+	for (size_t panel = number_of_panels; panel-- > 0;) {
+		const size_t panel_start = panel * panel_width;
+		const size_t height = tiles.get_panel_columns(panel);
+
+		left_read.get();
+		if (panel > 0) {
+			left_read = read_row_block_async(panel - 1, next_left);
+		}
+
+		auto get_value = [&](size_t row, size_t column) {
+			const size_t other = column / panel_width;
+			return left
+				[(other - panel) * height * panel_width +
+				 (row - panel_start) * tiles.get_panel_columns(other) +
+				 column - other * panel_width];
+		};
+
+		// Each row is solved with its values in the order of
+		// solve_upper_triangular, so that the solution is exactly the one of
+		// solving the system in memory
+		for (size_t row = panel_start + height; row-- > panel_start;) {
+			const size_t block_end =
+				size - (size - 1 - row) / TRIANGULAR_SOLVE_BLOCK_SIZE *
+						   TRIANGULAR_SOLVE_BLOCK_SIZE;
+			T *target = &solution[row * number_of_right_sides];
+			auto subtract_solved = [&](size_t start, size_t end) {
+				for (size_t i = start; i < end; ++i) {
+					const T coefficient = get_value(row, i);
+					const T *source = &solution[i * number_of_right_sides];
+					for (size_t column = 0; column < number_of_right_sides;
+						 ++column) {
+						target[column] -= coefficient * source[column];
+					}
+				}
+			};
+			subtract_solved(block_end, size);
+			subtract_solved(row + 1, block_end);
+
+			const T inverse_diagonal = 1. / get_value(row, row);
+			for (size_t column = 0; column < number_of_right_sides; ++column) {
+				target[column] *= inverse_diagonal;
+			}
+		}
+
+		std::swap(left, next_left);
+	}
+
+	return Matrix<T>(solution, size, number_of_right_sides);
+}
+
+#endif
@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <vector>
 
 size_t factorial(size_t n);
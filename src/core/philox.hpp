@@ -0,0 +1,60 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+constexpr uint32_t PHILOX_MULTIPLIER_0 = 0xD2511F53;
+constexpr uint32_t PHILOX_MULTIPLIER_1 = 0xCD9E8D57;
+constexpr uint32_t PHILOX_WEYL_0 = 0x9E3779B9;
+constexpr uint32_t PHILOX_WEYL_1 = 0xBB67AE85;
+constexpr size_t PHILOX_ROUNDS = 10;
+
+/*
+ * The Philox4x32-10 counter-based generator of Salmon et al., "Parallel
+ * random numbers: as easy as 1, 2, 3". It maps a counter and a key to four
+ * random 32-bit words without any state, so every value of a sequence can be
+ * computed on its own, by any thread and in any order.
+ */
+constexpr std::array<uint32_t, 4>
+philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+	for (size_t round = 0; round < PHILOX_ROUNDS; ++round) {
+		const uint64_t product_0 = uint64_t(PHILOX_MULTIPLIER_0) * counter[0];
+		const uint64_t product_1 = uint64_t(PHILOX_MULTIPLIER_1) * counter[2];
+		counter = {
+			uint32_t(product_1 >> 32) ^ counter[1] ^ key[0],
+			uint32_t(product_1),
+			uint32_t(product_0 >> 32) ^ counter[3] ^ key[1],
+			uint32_t(product_0)
+		};
+		key[0] += PHILOX_WEYL_0;
+		key[1] += PHILOX_WEYL_1;
+	}
+	return counter;
+}
+
+// Get the value at the index of the sequence given by the seed, uniformly
+// distributed in [0, 1)
+constexpr double philox_uniform(uint64_t seed, uint64_t index) {
+	// Every counter gives two values
+	const uint64_t counter = index / 2;
+	const auto words = philox4x32(
+		{uint32_t(counter), uint32_t(counter >> 32), 0, 0},
+		{uint32_t(seed), uint32_t(seed >> 32)}
+	);
+	const uint64_t bits = index % 2 == 0
+							  ? (uint64_t(words[0]) << 32) | words[1]
+							  : (uint64_t(words[2]) << 32) | words[3];
+	// The upper 53 bits fill the mantissa of a double exactly
+	return (bits >> 11) * 0x1.0p-53;
+}
+
+// Get the value at the index of the sequence given by the seed, uniformly
+// distributed between min and max
+constexpr double
+philox_uniform(uint64_t seed, uint64_t index, double min, double max) {
+	return min + (max - min) * philox_uniform(seed, index);
+}
+
+#endif
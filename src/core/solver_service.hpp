@@ -0,0 +1,589 @@
+#include "arena.hpp"
+#include "batched_system_of_equations.hpp"
+#include "matrix.hpp"
+#include "system_of_equations.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef SOLVER_SERVICE_H
+#define SOLVER_SERVICE_H
+
+constexpr uint32_t SERVICE_REQUEST_MAGIC = 0x51454d47;	// "GMEQ"
+constexpr uint32_t SERVICE_RESPONSE_MAGIC = 0x52454d47; // "GMER"
+
+// Solve requests for systems up to this size are batched together
+constexpr size_t SERVICE_BATCH_SIZE_LIMIT = 64;
+
+// The most values a matrix of a request may have, 2 GiB of doubles, so that a
+// malformed header cannot make the service allocate an arbitrary amount
+constexpr uint64_t SERVICE_MATRIX_VALUES_LIMIT = uint64_t(1) << 28;
+
+enum class ServiceOperation : uint32_t {
+	Solve = 0,
+	Invert = 1,
+	Determinant = 2,
+	Statistics = 3,
+};
+
+enum class ServiceStatus : uint32_t {
+	Ok = 0,
+	Error = 1,
+};
+
+/*
+ * Every request starts with this header and is followed by the map and, for
+ * solve requests, the right side, both as row-major arrays of values in the
+ * native byte order.
+ */
+struct ServiceRequestHeader {
+	uint32_t magic;
+	uint32_t operation;
+	uint64_t id;
+	uint64_t number_of_rows;
+	uint64_t number_of_columns;
+	uint64_t number_of_right_side_columns;
+};
+
+/*
+ * Every response starts with this header. A successful one is followed by the
+ * resulting matrix as a row-major array of values, a failed one by an error
+ * message of number_of_rows bytes.
+ */
+struct ServiceResponseHeader {
+	uint32_t magic;
+	uint32_t status;
+	uint64_t id;
+	uint64_t number_of_rows;
+	uint64_t number_of_columns;
+};
+
+// Reads exactly the given number of bytes, returning false on end of file
+inline bool read_exactly(int file_descriptor, void *buffer, size_t size) {
+	char *target = static_cast<char *>(buffer);
+	while (size > 0) {
+		ssize_t read_bytes = read(file_descriptor, target, size);
+		if (read_bytes == 0) {
+			return false;
+		}
+		if (read_bytes < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		target += read_bytes;
+		size -= read_bytes;
+	}
+	return true;
+}
+
+inline void
+write_exactly(int file_descriptor, const void *buffer, size_t size) {
+	const char *source = static_cast<const char *>(buffer);
+	while (size > 0) {
+		ssize_t written_bytes = write(file_descriptor, source, size);
+		if (written_bytes < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error("Could not write the response!");
+		}
+		source += written_bytes;
+		size -= written_bytes;
+	}
+}
+
+// A client of the service, either the standard streams or a socket
+class ServiceConnection {
+	private:
+	int input;
+	int output;
+	bool owns_descriptors;
+	std::mutex write_mutex;
+
+	public:
+	ServiceConnection(int input, int output, bool owns_descriptors)
+		: input(input), output(output), owns_descriptors(owns_descriptors) {}
+
+	ServiceConnection(const ServiceConnection &) = delete;
+	ServiceConnection &operator=(const ServiceConnection &) = delete;
+
+	~ServiceConnection() {
+		if (this->owns_descriptors) {
+			close(this->input);
+		}
+	}
+
+	int get_input() const { return this->input; }
+
+	// Stops the connection, which makes a pending read return
+	void shut_down() { shutdown(this->input, SHUT_RDWR); }
+
+	template <typename T>
+	void send_matrix(uint64_t id, const Matrix<T> &matrix) {
+		ServiceResponseHeader header{
+			SERVICE_RESPONSE_MAGIC,
+			static_cast<uint32_t>(ServiceStatus::Ok),
+			id,
+			matrix.get_number_of_rows(),
+			matrix.get_number_of_columns()
+		};
+		std::vector<T> values;
+		values.reserve(
+			matrix.get_number_of_rows() * matrix.get_number_of_columns()
+		);
+		for (size_t row = 0; row < matrix.get_number_of_rows(); ++row) {
+			for (size_t column = 0; column < matrix.get_number_of_columns();
+				 ++column) {
+				values.push_back(matrix.at(row, column));
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(this->write_mutex);
+		write_exactly(this->output, &header, sizeof(header));
+		write_exactly(this->output, values.data(), values.size() * sizeof(T));
+	}
+
+	void send_error(uint64_t id, const std::string &message) {
+		ServiceResponseHeader header{
+			SERVICE_RESPONSE_MAGIC,
+			static_cast<uint32_t>(ServiceStatus::Error),
+			id,
+			message.size(),
+			0
+		};
+
+		std::lock_guard<std::mutex> lock(this->write_mutex);
+		write_exactly(this->output, &header, sizeof(header));
+		write_exactly(this->output, message.data(), message.size());
+	}
+};
+
+template <typename T> struct ServiceRequest {
+	ServiceOperation operation;
+	uint64_t id;
+	Matrix<T> map;
+	std::optional<Matrix<T>> right_side;
+	std::shared_ptr<ServiceConnection> connection;
+	std::chrono::high_resolution_clock::time_point received_at;
+};
+
+/*
+ * A long running solver. Requests are read from any number of connections
+ * and queued, a single executor takes everything that has queued up while it
+ * was busy and solves it, so small solve requests of the same size that
+ * arrive close to each other are solved together by the batched solver. The
+ * shared thread pool and the arena the executor allocates from stay warm
+ * between requests.
+ */
+template <typename T> class SolverService {
+	private:
+	std::vector<ServiceRequest<T>> queue;
+	std::mutex queue_mutex;
+	std::condition_variable request_available;
+	size_t number_of_readers = 0;
+
+	ArenaMemoryResource arena;
+	std::vector<double> latencies;
+	std::mutex latencies_mutex;
+
+	// Checks that a matrix of the given size is within the limit, without
+	// overflowing on the way
+	static void check_matrix_size(
+		uint64_t number_of_rows, uint64_t number_of_columns
+	) {
+		if (number_of_rows != 0 &&
+			number_of_columns > SERVICE_MATRIX_VALUES_LIMIT / number_of_rows) {
+			throw std::runtime_error("The matrix of the request is too large!");
+		}
+	}
+
+	// Checks the parts of a header that cannot be trusted before anything is
+	// allocated based on them
+	static void check_header(const ServiceRequestHeader &header) {
+		if (header.magic != SERVICE_REQUEST_MAGIC) {
+			throw std::runtime_error("Malformed request!");
+		}
+		if (header.operation >
+			static_cast<uint32_t>(ServiceOperation::Statistics)) {
+			throw std::runtime_error("Unknown operation!");
+		}
+		check_matrix_size(header.number_of_rows, header.number_of_columns);
+		if (header.operation ==
+			static_cast<uint32_t>(ServiceOperation::Solve)) {
+			check_matrix_size(
+				header.number_of_rows, header.number_of_right_side_columns
+			);
+		}
+	}
+
+	// Reads a matrix of the given size, allocated outside of the arena since
+	// it lives until the executor has answered the request
+	static std::optional<Matrix<T>>
+	read_matrix(int input, size_t number_of_rows, size_t number_of_columns) {
+		MatrixStorage<T> data(
+			number_of_rows * number_of_columns, std::pmr::new_delete_resource()
+		);
+		if (!read_exactly(input, data.data(), data.size() * sizeof(T))) {
+			return std::nullopt;
+		}
+		return Matrix<T>(std::move(data), number_of_rows, number_of_columns);
+	}
+
+	void respond(
+		const ServiceRequest<T> &request,
+		const std::optional<Matrix<T>> &result,
+		const std::string &error = ""
+	) {
+		try {
+			if (result.has_value()) {
+				request.connection->send_matrix(request.id, *result);
+			} else {
+				request.connection->send_error(request.id, error);
+			}
+		} catch (const std::exception &exception) {
+			// The client went away, there is nobody to tell
+		}
+
+		std::chrono::duration<double> latency =
+			std::chrono::high_resolution_clock::now() - request.received_at;
+		std::lock_guard<std::mutex> lock(this->latencies_mutex);
+		this->latencies.push_back(latency.count());
+	}
+
+	Matrix<T> execute(const ServiceRequest<T> &request) {
+		switch (request.operation) {
+		case ServiceOperation::Solve: {
+			return solve_system_of_equations(
+				request.map, *request.right_side, true
+			);
+		}
+		case ServiceOperation::Invert: {
+			return request.map.get_inverse(true);
+		}
+		case ServiceOperation::Determinant: {
+			return Matrix<T>(
+				std::vector<T>{static_cast<T>(request.map.get_determinant(
+					DeterminantMethod::ParallelElimination
+				))},
+				1,
+				1
+			);
+		}
+		case ServiceOperation::Statistics: {
+			auto statistics = this->get_latency_statistics();
+			return Matrix<T>(
+				std::vector<T>(statistics.begin(), statistics.end()), 1, 5
+			);
+		}
+		default:
+			throw std::runtime_error("Unknown operation!");
+		}
+	}
+
+	// Whether a request can be solved together with others of its size
+	static bool is_batchable(const ServiceRequest<T> &request) {
+		return request.operation == ServiceOperation::Solve &&
+			   request.map.get_number_of_rows() <= SERVICE_BATCH_SIZE_LIMIT &&
+			   request.map.get_number_of_rows() ==
+				   request.map.get_number_of_columns() &&
+			   request.right_side->get_number_of_columns() == 1;
+	}
+
+	void execute_batch(const std::vector<const ServiceRequest<T> *> &batch) {
+		const size_t size = batch.front()->map.get_number_of_rows();
+		std::vector<T> maps;
+		std::vector<T> right_sides;
+		maps.reserve(batch.size() * size * size);
+		right_sides.reserve(batch.size() * size);
+		for (const auto *request : batch) {
+			for (size_t row = 0; row < size; ++row) {
+				for (size_t column = 0; column < size; ++column) {
+					maps.push_back(request->map.at(row, column));
+				}
+				right_sides.push_back(request->right_side->at(row, 0));
+			}
+		}
+
+		std::optional<BatchedSolution<T>> batched_solution;
+		try {
+			batched_solution =
+				solve_batched_systems_of_equations_with_singular_flags(
+					maps, right_sides, size, true
+				);
+		} catch (const std::exception &exception) {
+			for (const auto *request : batch) {
+				this->respond(*request, std::nullopt, exception.what());
+			}
+			return;
+		}
+
+		for (size_t i = 0; i < batch.size(); ++i) {
+			// Answered like a request solved on its own
+			if (batched_solution->singular[i]) {
+				this->respond(*batch[i], std::nullopt, "The matrix is singular!");
+				continue;
+			}
+
+			std::vector<T> solution(size);
+			for (size_t row = 0; row < size; ++row) {
+				solution[row] = batched_solution->solutions.at(i, row);
+			}
+			this->respond(*batch[i], Matrix<T>(solution, size, 1));
+		}
+	}
+
+	void execute_all(std::vector<ServiceRequest<T>> &requests) {
+		DefaultResourceGuard guard(&this->arena);
+
+		std::map<size_t, std::vector<const ServiceRequest<T> *>> batches;
+		for (const auto &request : requests) {
+			if (is_batchable(request)) {
+				batches[request.map.get_number_of_rows()].push_back(&request);
+				continue;
+			}
+
+			try {
+				this->respond(request, this->execute(request));
+			} catch (const std::exception &exception) {
+				this->respond(request, std::nullopt, exception.what());
+			}
+		}
+
+		for (const auto &[size, batch] : batches) {
+			this->execute_batch(batch);
+		}
+
+		requests.clear();
+		this->arena.reset();
+	}
+
+	// Reads requests from a connection until it is closed. A malformed
+	// request, or one that cannot be read for lack of memory, is answered
+	// with an error and the connection is dropped, since the rest of the
+	// stream cannot be made sense of, but the service keeps running.
+	void read_requests(std::shared_ptr<ServiceConnection> connection) {
+		ServiceRequestHeader header{};
+		try {
+			while (read_exactly(
+				connection->get_input(), &header, sizeof(header)
+			)) {
+				auto received_at = std::chrono::high_resolution_clock::now();
+				check_header(header);
+
+				auto operation = static_cast<ServiceOperation>(header.operation);
+				auto map = read_matrix(
+					connection->get_input(),
+					header.number_of_rows,
+					header.number_of_columns
+				);
+				if (!map.has_value()) {
+					break;
+				}
+
+				std::optional<Matrix<T>> right_side;
+				if (operation == ServiceOperation::Solve) {
+					right_side = read_matrix(
+						connection->get_input(),
+						header.number_of_rows,
+						header.number_of_right_side_columns
+					);
+					if (!right_side.has_value()) {
+						break;
+					}
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(this->queue_mutex);
+					this->queue.push_back(ServiceRequest<T>{
+						operation,
+						header.id,
+						std::move(*map),
+						std::move(right_side),
+						connection,
+						received_at
+					});
+				}
+				this->request_available.notify_one();
+			}
+		} catch (const std::exception &exception) {
+			try {
+				connection->send_error(header.id, exception.what());
+			} catch (const std::exception &) {
+				// The client went away, there is nobody to tell
+			}
+			connection->shut_down();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(this->queue_mutex);
+			--this->number_of_readers;
+		}
+		this->request_available.notify_one();
+	}
+
+	public:
+	// Starts reading requests from a connection on a new thread
+	std::thread start_reader(std::shared_ptr<ServiceConnection> connection) {
+		{
+			std::lock_guard<std::mutex> lock(this->queue_mutex);
+			++this->number_of_readers;
+		}
+		return std::thread(
+			&SolverService<T>::read_requests, this, std::move(connection)
+		);
+	}
+
+	// Executes requests until all readers are done and nothing is queued, or
+	// until the flag is raised
+	void run(const std::atomic<bool> &stopping, bool stop_without_readers) {
+		std::vector<ServiceRequest<T>> requests;
+		while (!stopping) {
+			{
+				std::unique_lock<std::mutex> lock(this->queue_mutex);
+				// Wake up regularly to notice the flag
+				this->request_available.wait_for(
+					lock,
+					std::chrono::milliseconds(100),
+					[this, stop_without_readers]() {
+						return !this->queue.empty() ||
+							   (stop_without_readers &&
+								this->number_of_readers == 0);
+					}
+				);
+				if (this->queue.empty()) {
+					if (stop_without_readers && this->number_of_readers == 0) {
+						return;
+					}
+					continue;
+				}
+				std::swap(requests, this->queue);
+			}
+
+			this->execute_all(requests);
+		}
+	}
+
+	// Get the number of requests and the 50th, 90th and 99th percentile and
+	// the maximum of their latencies in seconds
+	std::vector<double> get_latency_statistics() {
+		std::vector<double> sorted_latencies;
+		{
+			std::lock_guard<std::mutex> lock(this->latencies_mutex);
+			sorted_latencies = this->latencies;
+		}
+		std::sort(sorted_latencies.begin(), sorted_latencies.end());
+
+		auto percentile = [&sorted_latencies](double fraction) {
+			if (sorted_latencies.empty()) {
+				return 0.;
+			}
+			size_t rank = std::ceil(fraction * sorted_latencies.size());
+			return sorted_latencies[std::max<size_t>(rank, 1) - 1];
+		};
+
+		return {
+			static_cast<double>(sorted_latencies.size()),
+			percentile(0.5),
+			percentile(0.9),
+			percentile(0.99),
+			percentile(1)
+		};
+	}
+};
+
+// Serves requests from the standard input and answers on the standard output
+// until the input is closed, returning the latency statistics
+template <typename T> std::vector<double> serve_standard_streams() {
+	SolverService<T> service;
+	std::atomic<bool> stopping{false};
+
+	std::thread reader = service.start_reader(
+		std::make_shared<ServiceConnection>(STDIN_FILENO, STDOUT_FILENO, false)
+	);
+	service.run(stopping, true);
+	reader.join();
+
+	return service.get_latency_statistics();
+}
+
+// Serves requests from clients connecting to a Unix domain socket until the
+// flag is raised, returning the latency statistics
+template <typename T>
+std::vector<double>
+serve_unix_socket(const std::string &path, const std::atomic<bool> &stopping) {
+	sockaddr_un address{};
+	if (path.size() >= sizeof(address.sun_path)) {
+		throw std::runtime_error("The socket path is too long!");
+	}
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener == -1 ||
+		bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)
+		) == -1 ||
+		listen(listener, SOMAXCONN) == -1) {
+		throw std::runtime_error("Could not listen on " + path);
+	}
+
+	SolverService<T> service;
+	std::thread executor([&service, &stopping]() {
+		service.run(stopping, false);
+	});
+
+	std::vector<std::shared_ptr<ServiceConnection>> connections;
+	std::vector<std::thread> readers;
+	while (!stopping) {
+		// Wake up regularly to notice the flag
+		pollfd listener_poll{listener, POLLIN, 0};
+		if (poll(&listener_poll, 1, 100) <= 0) {
+			continue;
+		}
+
+		int client = accept(listener, nullptr, nullptr);
+		if (client == -1) {
+			continue;
+		}
+		connections.push_back(
+			std::make_shared<ServiceConnection>(client, client, true)
+		);
+		readers.push_back(service.start_reader(connections.back()));
+	}
+
+	for (auto &connection : connections) {
+		connection->shut_down();
+	}
+	for (auto &reader : readers) {
+		reader.join();
+	}
+	executor.join();
+	close(listener);
+	unlink(path.c_str());
+
+	return service.get_latency_statistics();
+}
+
+#endif
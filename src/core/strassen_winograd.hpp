@@ -0,0 +1,284 @@
+#include "matrix.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+#include <vector>
+
+#ifndef STRASSEN_WINOGRAD_H
+#define STRASSEN_WINOGRAD_H
+
+// The recursion stops once the smallest dimension of a block would drop below
+// this, where the classical kernel becomes faster than saving an eighth of the
+// multiplications
+constexpr size_t STRASSEN_WINOGRAD_CUTOFF = 64;
+// Number of rows of B the classical kernel goes through before moving on, so
+// that they stay in the cache for all rows of A
+constexpr size_t CLASSICAL_BLOCK_SIZE = 64;
+
+enum class MultiplicationMethod {
+	Classical,
+	StrassenWinograd,
+};
+
+// Computes C = A * B for row-major blocks of m x k and k x n values, where the
+// stride is the distance between the starts of two rows
+template <typename T>
+void multiply_blocks_classically(
+	const T *a,
+	size_t a_stride,
+	const T *b,
+	size_t b_stride,
+	T *c,
+	size_t c_stride,
+	size_t m,
+	size_t k,
+	size_t n
+) {
+	for (size_t row = 0; row < m; ++row) {
+		std::fill(c + row * c_stride, c + row * c_stride + n, 0);
+	}
+
+	for (size_t block_start = 0; block_start < k;
+		 block_start += CLASSICAL_BLOCK_SIZE) {
+		const size_t block_end = std::min(block_start + CLASSICAL_BLOCK_SIZE, k);
+		for (size_t row = 0; row < m; ++row) {
+			T *target = c + row * c_stride;
+			for (size_t i = block_start; i < block_end; ++i) {
+				const T factor = a[row * a_stride + i];
+				const T *source = b + i * b_stride;
+				for (size_t column = 0; column < n; ++column) {
+					target[column] += factor * source[column];
+				}
+			}
+		}
+	}
+}
+
+/*
+ * Computes C = A * B with Winograd's variant of Strassen's algorithm, which
+ * needs seven products of quarter sized blocks and fifteen additions instead
+ * of eight products. All dimensions have to be divisible by 2^depth. On the
+ * first level, the seven products run in parallel on the shared thread pool.
+ */
+template <typename T>
+void multiply_blocks_strassen_winograd(
+	const T *a,
+	size_t a_stride,
+	const T *b,
+	size_t b_stride,
+	T *c,
+	size_t c_stride,
+	size_t m,
+	size_t k,
+	size_t n,
+	size_t depth,
+	bool parallel
+) {
+	if (depth == 0) {
+		multiply_blocks_classically(
+			a, a_stride, b, b_stride, c, c_stride, m, k, n
+		);
+		return;
+	}
+
+	const size_t half_m = m / 2;
+	const size_t half_k = k / 2;
+	const size_t half_n = n / 2;
+
+	const T *a11 = a;
+	const T *a12 = a + half_k;
+	const T *a21 = a + half_m * a_stride;
+	const T *a22 = a21 + half_k;
+	const T *b11 = b;
+	const T *b12 = b + half_n;
+	const T *b21 = b + half_k * b_stride;
+	const T *b22 = b21 + half_n;
+
+	// S1 = A21 + A22, S2 = S1 - A11, S3 = A11 - A21, S4 = A12 - S2
+	const size_t a_block_size = half_m * half_k;
+	std::pmr::vector<T> s(4 * a_block_size);
+	T *s1 = s.data();
+	T *s2 = s1 + a_block_size;
+	T *s3 = s2 + a_block_size;
+	T *s4 = s3 + a_block_size;
+	for (size_t row = 0; row < half_m; ++row) {
+		for (size_t column = 0; column < half_k; ++column) {
+			const size_t source = row * a_stride + column;
+			const size_t target = row * half_k + column;
+			s1[target] = a21[source] + a22[source];
+			s2[target] = s1[target] - a11[source];
+			s3[target] = a11[source] - a21[source];
+			s4[target] = a12[source] - s2[target];
+		}
+	}
+
+	// T1 = B12 - B11, T2 = B22 - T1, T3 = B22 - B12, T4 = T2 - B21
+	const size_t b_block_size = half_k * half_n;
+	std::pmr::vector<T> t(4 * b_block_size);
+	T *t1 = t.data();
+	T *t2 = t1 + b_block_size;
+	T *t3 = t2 + b_block_size;
+	T *t4 = t3 + b_block_size;
+	for (size_t row = 0; row < half_k; ++row) {
+		for (size_t column = 0; column < half_n; ++column) {
+			const size_t source = row * b_stride + column;
+			const size_t target = row * half_n + column;
+			t1[target] = b12[source] - b11[source];
+			t2[target] = b22[source] - t1[target];
+			t3[target] = b22[source] - b12[source];
+			t4[target] = t2[target] - b21[source];
+		}
+	}
+
+	const size_t c_block_size = half_m * half_n;
+	std::pmr::vector<T> p(7 * c_block_size);
+	struct SubProduct {
+		const T *lhs;
+		size_t lhs_stride;
+		const T *rhs;
+		size_t rhs_stride;
+	};
+	const SubProduct sub_products[7] = {
+		{a11, a_stride, b11, b_stride}, // P1 = A11 * B11
+		{a12, a_stride, b21, b_stride}, // P2 = A12 * B21
+		{s4, half_k, b22, b_stride},	// P3 = S4 * B22
+		{a22, a_stride, t4, half_n},	// P4 = A22 * T4
+		{s1, half_k, t1, half_n},		// P5 = S1 * T1
+		{s2, half_k, t2, half_n},		// P6 = S2 * T2
+		{s3, half_k, t3, half_n},		// P7 = S3 * T3
+	};
+	auto multiply_sub_product = [&](size_t index) {
+		const SubProduct &sub_product = sub_products[index];
+		multiply_blocks_strassen_winograd(
+			sub_product.lhs,
+			sub_product.lhs_stride,
+			sub_product.rhs,
+			sub_product.rhs_stride,
+			p.data() + index * c_block_size,
+			half_n,
+			half_m,
+			half_k,
+			half_n,
+			depth - 1,
+			false
+		);
+	};
+	if (parallel) {
+		ThreadPool::shared().run(7, multiply_sub_product);
+	} else {
+		for (size_t index = 0; index < 7; ++index) {
+			multiply_sub_product(index);
+		}
+	}
+
+	// C11 = P1 + P2, U2 = P1 + P6, U3 = U2 + P7, C12 = U2 + P5 + P3,
+	// C21 = U3 - P4, C22 = U3 + P5
+	T *c11 = c;
+	T *c12 = c + half_n;
+	T *c21 = c + half_m * c_stride;
+	T *c22 = c21 + half_n;
+	for (size_t row = 0; row < half_m; ++row) {
+		for (size_t column = 0; column < half_n; ++column) {
+			const size_t source = row * half_n + column;
+			const size_t target = row * c_stride + column;
+			const T *product = p.data() + source;
+			const T u2 = product[0] + product[5 * c_block_size];
+			const T u3 = u2 + product[6 * c_block_size];
+			const T p5 = product[4 * c_block_size];
+			c11[target] = product[0] + product[c_block_size];
+			c12[target] = u2 + p5 + product[2 * c_block_size];
+			c21[target] = u3 - product[3 * c_block_size];
+			c22[target] = u3 + p5;
+		}
+	}
+}
+
+// Copies a matrix into a zero padded row-major buffer with the given size
+template <typename T>
+std::pmr::vector<T> get_padded_data(
+	const Matrix<T> &matrix, size_t number_of_rows, size_t number_of_columns
+) {
+	std::pmr::vector<T> data(number_of_rows * number_of_columns, 0);
+	for (size_t row = 0; row < matrix.get_number_of_rows(); ++row) {
+		std::copy(
+			&matrix.at(row, 0),
+			&matrix.at(row, 0) + matrix.get_number_of_columns(),
+			&data[row * number_of_columns]
+		);
+	}
+	return data;
+}
+
+/*
+ * Multiplies two matrices with the given method. For Strassen-Winograd, the
+ * number of levels follows from the smallest dimension and the cutoff. Each
+ * dimension is then padded with zeros to the next multiple of 2^levels, which
+ * adds less than 2^levels rows or columns, so rectangular and odd shapes cost
+ * about as much as the nearest power of two multiple of the cutoff would.
+ */
+template <typename T>
+Matrix<T> multiply(
+	const Matrix<T> &lhs,
+	const Matrix<T> &rhs,
+	MultiplicationMethod method,
+	bool parallel = true
+) {
+	if (lhs.get_number_of_columns() != rhs.get_number_of_rows()) {
+		throw std::runtime_error("Cannot multiply matrices of these sizes!");
+	}
+
+	const size_t m = lhs.get_number_of_rows();
+	const size_t k = lhs.get_number_of_columns();
+	const size_t n = rhs.get_number_of_columns();
+
+	size_t depth = 0;
+	if (method == MultiplicationMethod::StrassenWinograd) {
+		const size_t smallest_dimension = std::min({m, k, n});
+		while ((smallest_dimension >> (depth + 1)) >= STRASSEN_WINOGRAD_CUTOFF) {
+			++depth;
+		}
+	}
+	if (depth == 0) {
+		return lhs * rhs;
+	}
+
+	const size_t multiple = size_t(1) << depth;
+	auto pad = [multiple](size_t dimension) {
+		return (dimension + multiple - 1) / multiple * multiple;
+	};
+	const size_t padded_m = pad(m);
+	const size_t padded_k = pad(k);
+	const size_t padded_n = pad(n);
+
+	std::pmr::vector<T> padded_lhs = get_padded_data(lhs, padded_m, padded_k);
+	std::pmr::vector<T> padded_rhs = get_padded_data(rhs, padded_k, padded_n);
+	std::pmr::vector<T> padded_product(padded_m * padded_n);
+	multiply_blocks_strassen_winograd(
+		padded_lhs.data(),
+		padded_k,
+		padded_rhs.data(),
+		padded_n,
+		padded_product.data(),
+		padded_n,
+		padded_m,
+		padded_k,
+		padded_n,
+		depth,
+		parallel
+	);
+
+	MatrixStorage<T> product(m * n);
+	for (size_t row = 0; row < m; ++row) {
+		std::copy(
+			&padded_product[row * padded_n],
+			&padded_product[row * padded_n] + n,
+			&product[row * n]
+		);
+	}
+	return Matrix<T>(std::move(product), m, n);
+}
+
+#endif
@@ -1,5 +1,7 @@
+#include "condition_estimate.hpp"
 #include "eliminable_matrix.hpp"
 #include "matrix.hpp"
+#include "strassen_winograd.hpp"
 
 #include <stdexcept>
 
@@ -7,8 +9,12 @@
 #define SYSTEM_OF_EQUATIONS_H
 
 template <typename T>
-Matrix<T>
-solve_system_of_equations(Matrix<T> map, Matrix<T> right_side, bool parallel) {
+Matrix<T> solve_system_of_equations(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+) {
 	if (map.get_number_of_rows() != map.get_number_of_columns()) {
 		throw std::runtime_error(
 			"Cannot solve a system of equations with a non-square matrix!"
@@ -19,22 +25,79 @@ solve_system_of_equations(Matrix<T> map, Matrix<T> right_side, bool parallel) {
 		map.right_join(right_side).get_eliminable();
 
 	eliminable_matrix.perform_gem(parallel);
-	eliminable_matrix.perform_jem(parallel);
-	eliminable_matrix.normalize_rows_based_on_diagonal(parallel);
+	eliminable_matrix.perform_back_substitution(
+		back_substitution_method, parallel
+	);
 
 	return eliminable_matrix.extract_column_range(map.get_number_of_columns());
 }
 
+// A solution together with an estimate of how accurate it is
+template <typename T> struct EstimatedSolution {
+	Matrix<T> solution;
+	AccuracyEstimate<T> accuracy;
+};
+
+// Solves the system like solve_system_of_equations and estimates the
+// accuracy of the solution from the factors of GEM on the way, which costs
+// O(n^2) on top of the O(n^3) of the elimination
+template <typename T>
+EstimatedSolution<T> solve_system_of_equations_with_estimate(
+	Matrix<T> map,
+	Matrix<T> right_side,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method
+) {
+	if (map.get_number_of_rows() != map.get_number_of_columns()) {
+		throw std::runtime_error(
+			"Cannot solve a system of equations with a non-square matrix!"
+		);
+	}
+
+	EliminableMatrix<T> eliminable_matrix =
+		map.right_join(right_side).get_eliminable();
+
+	eliminable_matrix.perform_gem(parallel);
+	const AccuracyEstimate<T> accuracy =
+		eliminable_matrix.estimate_accuracy(map.get_one_norm());
+	eliminable_matrix.perform_back_substitution(
+		back_substitution_method, parallel
+	);
+
+	return EstimatedSolution<T>{
+		eliminable_matrix.extract_column_range(map.get_number_of_columns()),
+		accuracy
+	};
+}
+
+template <typename T>
+Matrix<T>
+solve_system_of_equations(Matrix<T> map, Matrix<T> right_side, bool parallel) {
+	return solve_system_of_equations(
+		map, right_side, parallel, BackSubstitutionMethod::Triangular
+	);
+}
+
 template <typename T>
 Matrix<T> solve_system_of_equations(Matrix<T> map, Matrix<T> right_side) {
 	return solve_system_of_equations(map, right_side, true);
 }
 
+// Get the norm of B - A * X. The classical product is evaluated row by row
+// together with the difference, any other one is computed on its own first.
 template <typename T>
 T get_residue(
-	Matrix<T> &map, Matrix<T> &right_side, Matrix<T> &computed_solution
+	Matrix<T> &map,
+	Matrix<T> &right_side,
+	Matrix<T> &computed_solution,
+	MultiplicationMethod multiplication_method = MultiplicationMethod::Classical
 ) {
-	return abs(right_side - map * computed_solution);
+	if (multiplication_method == MultiplicationMethod::Classical) {
+		return abs(right_side - map * computed_solution);
+	}
+	return abs(
+		right_side - multiply(map, computed_solution, multiplication_method)
+	);
 }
 
 template <typename T>
@@ -0,0 +1,177 @@
+#include "numa.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/*
+ * A fixed set of worker threads that are started once and then kept waiting
+ * for tasks, so that parallel kernels do not pay for spawning and joining
+ * threads every time they run. Every worker is pinned to its own CPU, with
+ * the workers of a NUMA node numbered consecutively, and run() always gives
+ * the same index to the same worker, so that a kernel can keep the data of an
+ * index on the node of the worker that processes it.
+ */
+class ThreadPool {
+	private:
+	std::vector<std::thread> workers;
+	std::vector<int> worker_nodes;
+	std::vector<std::queue<std::function<void()>>> worker_tasks;
+	std::mutex mutex;
+	std::condition_variable task_available;
+	bool stopping = false;
+
+	// Set in the worker threads, so that nested parallel work can run inline
+	// instead of waiting for workers that are all busy waiting themselves
+	static bool &is_worker_thread() {
+		static thread_local bool is_worker = false;
+		return is_worker;
+	}
+
+	void work(size_t worker_index) {
+		is_worker_thread() = true;
+		auto &own_tasks = this->worker_tasks[worker_index];
+		while (true) {
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(this->mutex);
+				this->task_available.wait(lock, [this, &own_tasks]() {
+					return this->stopping || !own_tasks.empty();
+				});
+				if (own_tasks.empty()) {
+					return;
+				}
+				task = std::move(own_tasks.front());
+				own_tasks.pop();
+			}
+			task();
+		}
+	}
+
+	// Every worker waits on the same condition, so all of them have to be
+	// woken up to make sure the right one is
+	void enqueue_to(size_t worker_index, std::function<void()> task) {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->worker_tasks[worker_index].push(std::move(task));
+		}
+		this->task_available.notify_all();
+	}
+
+	public:
+	// Get the pool shared by all parallel kernels, with one worker pinned to
+	// every CPU the process may run on
+	static ThreadPool &shared() {
+		static ThreadPool pool(NumaTopology::detect());
+		return pool;
+	}
+
+	// Start one worker per CPU of the topology, pinned to it
+	ThreadPool(const NumaTopology &topology) {
+		std::vector<int> worker_cpus;
+		for (const auto &node : topology.get_nodes()) {
+			for (int cpu : node.cpus) {
+				worker_cpus.push_back(cpu);
+				this->worker_nodes.push_back(node.id);
+			}
+		}
+		this->worker_tasks.resize(worker_cpus.size());
+		this->workers.reserve(worker_cpus.size());
+		for (size_t i = 0; i < worker_cpus.size(); ++i) {
+			this->workers.emplace_back(&ThreadPool::work, this, i);
+		}
+
+		// Pinning is only an optimization, so failing to pin is ignored
+		for (size_t i = 0; i < this->workers.size(); ++i) {
+			cpu_set_t cpus;
+			CPU_ZERO(&cpus);
+			CPU_SET(worker_cpus[i], &cpus);
+			pthread_setaffinity_np(
+				this->workers[i].native_handle(), sizeof(cpus), &cpus
+			);
+		}
+	}
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(this->mutex);
+			this->stopping = true;
+		}
+		this->task_available.notify_all();
+		for (auto &worker : this->workers) {
+			worker.join();
+		}
+	}
+
+	size_t get_number_of_threads() const { return this->workers.size(); }
+
+	// Get the NUMA node the worker runs on
+	int get_worker_node(size_t worker_index) const {
+		return this->worker_nodes[worker_index];
+	}
+
+	// Call the function for every index in [0, count) and wait for all calls
+	// to finish. Index i always runs on worker i modulo the number of workers.
+	template <typename Function> void run(size_t count, Function function) {
+		if (count == 0) {
+			return;
+		}
+		if (count == 1 || is_worker_thread()) {
+			for (size_t index = 0; index < count; ++index) {
+				function(index);
+			}
+			return;
+		}
+
+		const size_t number_of_workers =
+			std::min(count, this->get_number_of_threads());
+		std::vector<std::future<void>> results;
+		results.reserve(number_of_workers);
+		for (size_t worker_index = 0; worker_index < number_of_workers;
+			 ++worker_index) {
+			auto task = std::make_shared<std::packaged_task<void()>>(
+				[&function, count, number_of_workers, worker_index]() {
+					for (size_t index = worker_index; index < count;
+						 index += number_of_workers) {
+						function(index);
+					}
+				}
+			);
+			results.push_back(task->get_future());
+			this->enqueue_to(worker_index, [task]() { (*task)(); });
+		}
+
+		// The tasks refer to this frame, so they all have to finish before an
+		// exception may leave it
+		std::exception_ptr exception;
+		for (auto &result : results) {
+			try {
+				result.get();
+			} catch (...) {
+				exception = std::current_exception();
+			}
+		}
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+	}
+};
+
+#endif
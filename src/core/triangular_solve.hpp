@@ -0,0 +1,101 @@
+#include "matrix_expression.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#ifndef TRIANGULAR_SOLVE_H
+#define TRIANGULAR_SOLVE_H
+
+// Number of rows solved together, and of solved rows applied to them together
+constexpr size_t TRIANGULAR_SOLVE_BLOCK_SIZE = 64;
+
+/*
+ * Solves U * X = B in place for the columns [start_column, end_column) of B,
+ * where U is the upper triangle, diagonal included, of the size x size
+ * row-major matrix at u. The rows go in blocks from the bottom up. Each block
+ * is first updated by the solved rows below it, a block of them at a time so
+ * that they stay in the cache for all rows of the block, and then its own
+ * triangle is solved row by row.
+ */
+template <typename T>
+void solve_upper_triangular_columns(
+	const T *u,
+	size_t u_stride,
+	T *b,
+	size_t b_stride,
+	size_t size,
+	size_t start_column,
+	size_t end_column
+) {
+	if (start_column >= end_column) {
+		return;
+	}
+
+	for (size_t block_end = size; block_end > 0;) {
+		const size_t block_start = block_end > TRIANGULAR_SOLVE_BLOCK_SIZE
+									   ? block_end - TRIANGULAR_SOLVE_BLOCK_SIZE
+									   : 0;
+
+		for (size_t solved_start = block_end; solved_start < size;
+			 solved_start += TRIANGULAR_SOLVE_BLOCK_SIZE) {
+			const size_t solved_end =
+				std::min(solved_start + TRIANGULAR_SOLVE_BLOCK_SIZE, size);
+			for (size_t row = block_start; row < block_end; ++row) {
+				T *target = b + row * b_stride;
+				for (size_t i = solved_start; i < solved_end; ++i) {
+					const T factor = u[row * u_stride + i];
+					const T *source = b + i * b_stride;
+					for (size_t column = start_column; column < end_column;
+						 ++column) {
+						target[column] -= factor * source[column];
+					}
+				}
+			}
+		}
+
+		for (size_t row = block_end; row-- > block_start;) {
+			T *target = b + row * b_stride;
+			for (size_t i = row + 1; i < block_end; ++i) {
+				const T factor = u[row * u_stride + i];
+				const T *source = b + i * b_stride;
+				for (size_t column = start_column; column < end_column;
+					 ++column) {
+					target[column] -= factor * source[column];
+				}
+			}
+			const T inverse_diagonal = 1. / u[row * u_stride + row];
+			for (size_t column = start_column; column < end_column; ++column) {
+				target[column] *= inverse_diagonal;
+			}
+		}
+
+		block_end = block_start;
+	}
+}
+
+// Solves U * X = B in place for all columns of B, splitting them among the
+// workers of the shared thread pool in whole cache lines if parallel
+template <typename T>
+void solve_upper_triangular(
+	const T *u,
+	size_t u_stride,
+	T *b,
+	size_t b_stride,
+	size_t size,
+	size_t number_of_columns,
+	bool parallel = true
+) {
+	auto solve_columns = [=](size_t start_column, size_t end_column, size_t) {
+		solve_upper_triangular_columns(
+			u, u_stride, b, b_stride, size, start_column, end_column
+		);
+	};
+
+	if (parallel) {
+		for_each_column_chunk<T>(number_of_columns, solve_columns);
+	} else {
+		solve_columns(0, number_of_columns, 0);
+	}
+}
+
+#endif
@@ -0,0 +1,78 @@
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#ifndef UNINITIALIZED_ALLOCATOR_H
+#define UNINITIALIZED_ALLOCATOR_H
+
+/*
+ * A polymorphic allocator that leaves values without an initializer
+ * uninitialized, so that resizing a vector does not write to its memory. The
+ * pages of a buffer are then first touched by whoever writes its values,
+ * which for matrices split between workers is the worker owning the rows.
+ * Buffers of a page or more start on a page boundary, so that their pages can
+ * be split between NUMA nodes exactly along the rows.
+ */
+template <typename T>
+class UninitializedAllocator : public std::pmr::polymorphic_allocator<T> {
+	private:
+	static size_t get_alignment(size_t number_of_values) {
+		static const size_t page_size = sysconf(_SC_PAGESIZE);
+		return number_of_values * sizeof(T) >= page_size ? page_size
+														 : alignof(T);
+	}
+
+	public:
+	using std::pmr::polymorphic_allocator<T>::polymorphic_allocator;
+
+	UninitializedAllocator() = default;
+
+	template <typename U>
+	UninitializedAllocator(const UninitializedAllocator<U> &other) noexcept
+		: std::pmr::polymorphic_allocator<T>(other.resource()) {}
+
+	T *allocate(size_t number_of_values) {
+		return static_cast<T *>(this->resource()->allocate(
+			number_of_values * sizeof(T), get_alignment(number_of_values)
+		));
+	}
+
+	void deallocate(T *pointer, size_t number_of_values) {
+		this->resource()->deallocate(
+			pointer,
+			number_of_values * sizeof(T),
+			get_alignment(number_of_values)
+		);
+	}
+
+	template <typename U> void construct(U *pointer) {
+		::new (static_cast<void *>(pointer)) U;
+	}
+
+	template <typename U, typename... Arguments>
+	void construct(U *pointer, Arguments &&...arguments) {
+		std::pmr::polymorphic_allocator<T>::construct(
+			pointer, std::forward<Arguments>(arguments)...
+		);
+	}
+
+	// Like the polymorphic allocator, a copy allocates from the default
+	// resource at the time it is made. That resource is global to the
+	// process, so while a DefaultResourceGuard installs an arena (during the
+	// steps of a complexity task and while the service executor runs), the
+	// copies made by any thread come from the arena.
+	UninitializedAllocator select_on_container_copy_construction() const {
+		return UninitializedAllocator();
+	}
+};
+
+// The storage of the values of a matrix. Unlike with std::pmr::vector, a size
+// given without a value leaves the values uninitialized.
+template <typename T>
+using MatrixStorage = std::vector<T, UninitializedAllocator<T>>;
+
+#endif
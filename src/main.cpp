@@ -1,10 +1,37 @@
+#include "./core/arena.hpp"
+#include "./core/async_solver.hpp"
+#include "./core/batched_system_of_equations.hpp"
+#include "./core/distributed_system_of_equations.hpp"
+#include "./core/factorization_cache.hpp"
+#include "./core/fixed_matrix.hpp"
+#include "./core/low_rank_update.hpp"
+#include "./core/numa.hpp"
+#include "./core/lu_factorization.hpp"
 #include "./core/matrix.hpp"
+#include "./core/matrix_generator.hpp"
+#include "./core/out_of_core_system_of_equations.hpp"
+#include "./core/solver_service.hpp"
+#include "./core/strassen_winograd.hpp"
 #include "./core/system_of_equations.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <fstream>
 #include <functional>
 #include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include <csignal>
 
 /*
  * The code in here could certainly be improved but since argument parsing was
@@ -18,20 +45,153 @@
 constexpr double MIN = 100;
 constexpr double MAX = -100;
 constexpr char NOT_ENOUGH_ARGS[] = "Not enough arguments!";
+constexpr size_t DEFAULT_CACHE_LIMIT = 1 << 30;
+// Bandwidth of the banded matrices used for measuring complexity
+constexpr size_t COMPLEXITY_BANDWIDTH = 16;
 
-enum class Command { Help, Generate, Solve, Invert, Complexity, Determinant };
-enum class ComplexityTask { SystemOfEquations, MatrixEquation, Determinant };
+enum class Command {
+	Help,
+	Generate,
+	Solve,
+	SolveBatch,
+	SolveUpdated,
+	DistributedSolve,
+	Batch,
+	Invert,
+	Complexity,
+	BenchmarkFixed,
+	Serve,
+	NumaBandwidth,
+	Determinant
+};
+enum class ComplexityTask {
+	SystemOfEquations,
+	MatrixEquation,
+	Determinant,
+	Multiplication
+};
 enum class SystemMethod { Parallel, Sequential };
-enum class MatrixType { Random, Identity, Ones, Hilbert };
+enum class MatrixType {
+	Random,
+	Identity,
+	Ones,
+	Hilbert,
+	DiagonallyDominant,
+	SymmetricPositiveDefinite,
+	Banded
+};
+
+// Removes an optional flag from the arguments and returns whether it was there
+bool take_flag(int &argc, char *argv[], const std::string &flag) {
+	for (int i = 1; i < argc; ++i) {
+		if (argv[i] == flag) {
+			std::copy(argv + i + 1, argv + argc, argv + i);
+			--argc;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Removes an optional option with a value from the arguments and returns the
+// value if it was there
+std::optional<std::string>
+take_option(int &argc, char *argv[], const std::string &option) {
+	for (int i = 1; i < argc - 1; ++i) {
+		if (argv[i] == option) {
+			std::string value = argv[i + 1];
+			std::copy(argv + i + 2, argv + argc, argv + i);
+			argc -= 2;
+			return value;
+		}
+	}
+	return std::nullopt;
+}
+
+// Parses a number of bytes with an optional K, M or G suffix
+size_t string_to_bytes(const std::string &string_bytes) {
+	size_t suffix_position;
+	size_t bytes = std::stoull(string_bytes, &suffix_position);
+
+	const std::string suffix = string_bytes.substr(suffix_position);
+	if (suffix == "G") {
+		return bytes << 30;
+	} else if (suffix == "M") {
+		return bytes << 20;
+	} else if (suffix == "K") {
+		return bytes << 10;
+	} else if (!suffix.empty()) {
+		throw std::runtime_error("Unknown size suffix: " + suffix);
+	}
+	return bytes;
+}
+
+// Removes the seed option from the arguments, drawing a seed if it was not
+// there
+uint64_t take_seed(int &argc, char *argv[]) {
+	auto seed = take_option(argc, argv, "--seed");
+	if (seed.has_value()) {
+		return std::stoull(*seed);
+	}
+	return (uint64_t(std::random_device()()) << 32) | std::random_device()();
+}
+
+// Removes the flag choosing JEM for the backward pass of GEM
+BackSubstitutionMethod take_back_substitution_method(int &argc, char *argv[]) {
+	return take_flag(argc, argv, "--jordan") ? BackSubstitutionMethod::Jordan
+											 : BackSubstitutionMethod::Triangular;
+}
+
+// Removes the cache options from the arguments and opens the cache if they
+// were there
+std::optional<FactorizationCache> take_cache(int &argc, char *argv[]) {
+	auto directory = take_option(argc, argv, "--cache");
+	auto size_limit = take_option(argc, argv, "--cache-limit");
+	if (!directory.has_value()) {
+		if (size_limit.has_value()) {
+			throw std::runtime_error("--cache-limit requires --cache!");
+		}
+		return std::nullopt;
+	}
+
+	return FactorizationCache(
+		*directory,
+		size_limit.has_value() ? string_to_bytes(*size_limit)
+							   : DEFAULT_CACHE_LIMIT
+	);
+}
+
+void print_accuracy_estimate(const AccuracyEstimate<FLOAT_TYPE> &accuracy) {
+	std::cout << "Condition number estimate: " << accuracy.condition_number
+			  << std::endl;
+	std::cout << "Forward error bound: " << accuracy.forward_error_bound
+			  << std::endl;
+}
+
+// The statistics go to the standard error, so that they do not mix with the
+// results
+void print_cache_statistics(const FactorizationCache &cache) {
+	auto statistics = cache.get_statistics();
+	std::cerr << "Cache hits: " << statistics.hits
+			  << ", misses: " << statistics.misses
+			  << ", evictions: " << statistics.evictions << std::endl;
+}
 
 Command string_to_command(const std::string &string_command) {
 	static const std::unordered_map<std::string, Command> command_map = {
 		{"--help", Command::Help},
 		{"generate", Command::Generate},
 		{"solve", Command::Solve},
+		{"solve-batch", Command::SolveBatch},
+		{"solve-updated", Command::SolveUpdated},
+		{"distributed-solve", Command::DistributedSolve},
+		{"batch", Command::Batch},
 		{"invert", Command::Invert},
 		{"determinant", Command::Determinant},
-		{"complexity", Command::Complexity}
+		{"complexity", Command::Complexity},
+		{"benchmark-fixed", Command::BenchmarkFixed},
+		{"serve", Command::Serve},
+		{"numa-bandwidth", Command::NumaBandwidth}
 	};
 
 	auto it = command_map.find(string_command);
@@ -41,11 +201,27 @@ Command string_to_command(const std::string &string_command) {
 	throw std::runtime_error("Unknown command: " + string_command);
 }
 
+DistributedTransportType
+string_to_transport_type(const std::string &string_transport) {
+	static const std::unordered_map<std::string, DistributedTransportType>
+		transport_map = {
+			{"shared-memory", DistributedTransportType::SharedMemory},
+			{"tcp", DistributedTransportType::Socket}
+		};
+
+	auto it = transport_map.find(string_transport);
+	if (it != transport_map.end()) {
+		return it->second;
+	}
+	throw std::runtime_error("Unknown transport: " + string_transport);
+}
+
 ComplexityTask string_to_complexity_task(const std::string &string_task) {
 	static const std::unordered_map<std::string, ComplexityTask> task_map = {
 		{"determinant", ComplexityTask::Determinant},
 		{"system", ComplexityTask::SystemOfEquations},
-		{"equation", ComplexityTask::MatrixEquation}
+		{"equation", ComplexityTask::MatrixEquation},
+		{"multiplication", ComplexityTask::Multiplication}
 	};
 
 	auto it = task_map.find(string_task);
@@ -85,12 +261,33 @@ DeterminantMethod string_to_determinant_method(const std::string &string_method
 	);
 }
 
+MultiplicationMethod string_to_multiplication_method(
+	const std::string &string_method
+) {
+	static const std::unordered_map<std::string, MultiplicationMethod>
+		method_map = {
+			{"classical", MultiplicationMethod::Classical},
+			{"strassen-winograd", MultiplicationMethod::StrassenWinograd}
+		};
+
+	auto it = method_map.find(string_method);
+	if (it != method_map.end()) {
+		return it->second;
+	}
+	throw std::runtime_error(
+		"Unknown method for multiplication: " + string_method
+	);
+}
+
 MatrixType string_to_matrix_type(const std::string &string_type) {
 	static const std::unordered_map<std::string, MatrixType> type_map = {
 		{"random", MatrixType::Random},
 		{"ones", MatrixType::Ones},
 		{"identity", MatrixType::Identity},
 		{"hilbert", MatrixType::Hilbert},
+		{"diagonally-dominant", MatrixType::DiagonallyDominant},
+		{"spd", MatrixType::SymmetricPositiveDefinite},
+		{"banded", MatrixType::Banded},
 	};
 
 	auto it = type_map.find(string_type);
@@ -100,27 +297,53 @@ MatrixType string_to_matrix_type(const std::string &string_type) {
 	throw std::runtime_error("Unknown matrix type: " + string_type);
 }
 
-Matrix<FLOAT_TYPE> get_matrix_of_type(MatrixType matrix_type, size_t size) {
+Matrix<FLOAT_TYPE>
+get_matrix_of_type(MatrixType matrix_type, size_t size, uint64_t seed) {
 	switch (matrix_type) {
 	case MatrixType::Random: {
-		return Matrix<FLOAT_TYPE>::random(size, MIN, MAX);
+		return Matrix<FLOAT_TYPE>::random(size, MIN, MAX, seed);
 	}
 	case MatrixType::Hilbert: {
 		return Matrix<FLOAT_TYPE>::hilbert(size);
 	}
+	case MatrixType::DiagonallyDominant: {
+		return MatrixGenerator<FLOAT_TYPE>::diagonally_dominant(
+				   size, MIN, MAX, seed
+		)
+			.generate();
+	}
+	case MatrixType::SymmetricPositiveDefinite: {
+		return MatrixGenerator<FLOAT_TYPE>::symmetric_positive_definite(
+				   size, MIN, MAX, seed
+		)
+			.generate();
+	}
+	case MatrixType::Banded: {
+		return MatrixGenerator<FLOAT_TYPE>::banded(
+				   size, COMPLEXITY_BANDWIDTH, MIN, MAX, seed
+		)
+			.generate();
+	}
 	default: {
 		throw std::runtime_error("We do not support getting this matrix type");
 	}
 	}
 }
 
+// The solution is drawn from a different sequence than the matrix
 Matrix<FLOAT_TYPE> get_solution_for_matrix_type(
-	MatrixType matrix_type, size_t number_of_rows, size_t number_of_columns
+	MatrixType matrix_type,
+	size_t number_of_rows,
+	size_t number_of_columns,
+	uint64_t seed
 ) {
 	switch (matrix_type) {
-	case MatrixType::Random: {
+	case MatrixType::Random:
+	case MatrixType::DiagonallyDominant:
+	case MatrixType::SymmetricPositiveDefinite:
+	case MatrixType::Banded: {
 		return Matrix<FLOAT_TYPE>::random(
-			number_of_rows, number_of_columns, MIN, MAX
+			number_of_rows, number_of_columns, MIN, MAX, seed + 1
 		);
 	}
 	case MatrixType::Hilbert: {
@@ -132,42 +355,267 @@ Matrix<FLOAT_TYPE> get_solution_for_matrix_type(
 	}
 }
 
-Matrix<FLOAT_TYPE>
-get_solution_for_matrix_type(MatrixType matrix_type, size_t size) {
-	return get_solution_for_matrix_type(matrix_type, size);
+Matrix<FLOAT_TYPE> get_solution_for_matrix_type(
+	MatrixType matrix_type, size_t size, uint64_t seed
+) {
+	return get_solution_for_matrix_type(matrix_type, size, size, seed);
 }
 
-void solve_system(MatrixType matrix_type, size_t size, bool parallel) {
-	auto map = get_matrix_of_type(matrix_type, size);
-	auto expected_solution = get_solution_for_matrix_type(matrix_type, size, 1);
-	auto right_side = map * expected_solution;
-
-	auto computed_solution =
-		solve_system_of_equations(map, right_side, parallel);
+// Prints the residue and the error of a computed solution, which take an
+// extra multiplication, or nan for both if they are skipped
+void print_verification(
+	Matrix<FLOAT_TYPE> &map,
+	Matrix<FLOAT_TYPE> &right_side,
+	Matrix<FLOAT_TYPE> &expected_solution,
+	Matrix<FLOAT_TYPE> &computed_solution,
+	MultiplicationMethod multiplication_method,
+	bool verify
+) {
+	if (!verify) {
+		std::cout << "nan, nan, ";
+		return;
+	}
 
-	auto residue = get_residue(map, right_side, computed_solution);
+	auto residue = get_residue(
+		map, right_side, computed_solution, multiplication_method
+	);
 	auto error = get_error(expected_solution, computed_solution);
 
 	std::cout << residue << ", " << error << ", ";
 }
 
-void solve_matrix_equation(MatrixType matrix_type, size_t size, bool parallel) {
-	auto map = get_matrix_of_type(matrix_type, size);
-	auto expected_solution = get_solution_for_matrix_type(matrix_type, size);
-	auto right_side = map * expected_solution;
+AccuracyEstimate<FLOAT_TYPE> solve_system(
+	MatrixType matrix_type,
+	size_t size,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method,
+	MultiplicationMethod multiplication_method,
+	bool verify,
+	uint64_t seed
+) {
+	auto map = get_matrix_of_type(matrix_type, size, seed);
+	auto expected_solution =
+		get_solution_for_matrix_type(matrix_type, size, 1, seed);
+	Matrix<FLOAT_TYPE> right_side =
+		multiply(map, expected_solution, multiplication_method);
 
-	auto computed_solution =
-		solve_system_of_equations(map, right_side, parallel);
-	auto residue = get_residue(map, right_side, computed_solution);
-	auto error = get_error(expected_solution, computed_solution);
+	auto estimated_solution = solve_system_of_equations_with_estimate(
+		map, right_side, parallel, back_substitution_method
+	);
+	print_verification(
+		map,
+		right_side,
+		expected_solution,
+		estimated_solution.solution,
+		multiplication_method,
+		verify
+	);
 
-	std::cout << residue << ", " << error << ", ";
+	return estimated_solution.accuracy;
+}
+
+AccuracyEstimate<FLOAT_TYPE> solve_matrix_equation(
+	MatrixType matrix_type,
+	size_t size,
+	bool parallel,
+	BackSubstitutionMethod back_substitution_method,
+	MultiplicationMethod multiplication_method,
+	bool verify,
+	uint64_t seed
+) {
+	auto map = get_matrix_of_type(matrix_type, size, seed);
+	auto expected_solution =
+		get_solution_for_matrix_type(matrix_type, size, seed);
+	Matrix<FLOAT_TYPE> right_side =
+		multiply(map, expected_solution, multiplication_method);
+
+	auto estimated_solution = solve_system_of_equations_with_estimate(
+		map, right_side, parallel, back_substitution_method
+	);
+	print_verification(
+		map,
+		right_side,
+		expected_solution,
+		estimated_solution.solution,
+		multiplication_method,
+		verify
+	);
+
+	return estimated_solution.accuracy;
 }
 
 void compute_determinant(
-	MatrixType matrix_type, size_t size, DeterminantMethod method
+	MatrixType matrix_type,
+	size_t size,
+	DeterminantMethod method,
+	uint64_t seed
+) {
+	get_matrix_of_type(matrix_type, size, seed).get_determinant(method);
+}
+
+// Multiplies two matrices with the method and compares the product with the
+// classical one
+void multiply_matrices(
+	MatrixType matrix_type,
+	size_t size,
+	MultiplicationMethod method,
+	uint64_t seed
+) {
+	auto lhs = get_matrix_of_type(matrix_type, size, seed);
+	auto rhs = get_matrix_of_type(matrix_type, size, seed + 1);
+
+	auto classical_start = std::chrono::high_resolution_clock::now();
+	auto classical_product =
+		multiply(lhs, rhs, MultiplicationMethod::Classical);
+	std::chrono::duration<double> classical_elapsed =
+		std::chrono::high_resolution_clock::now() - classical_start;
+
+	auto method_start = std::chrono::high_resolution_clock::now();
+	auto product = multiply(lhs, rhs, method);
+	std::chrono::duration<double> method_elapsed =
+		std::chrono::high_resolution_clock::now() - method_start;
+
+	auto error = abs(product - classical_product) / abs(classical_product);
+
+	std::cout << error << ", " << classical_elapsed.count() << ", "
+			  << method_elapsed.count() << ", ";
+}
+
+// Keeps the compiler from optimizing away computations whose result is unused
+template <typename V> void do_not_optimize(V &value) {
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Times solving the same system repeatedly through the dynamically sized and
+// the fixed size path
+template <size_t N>
+void benchmark_fixed_size(
+	MatrixType matrix_type, size_t repetitions, uint64_t seed
+) {
+	auto map = get_matrix_of_type(matrix_type, N, seed);
+	auto expected_solution =
+		get_solution_for_matrix_type(matrix_type, N, 1, seed);
+	Matrix<FLOAT_TYPE> right_side = map * expected_solution;
+
+	auto fixed_map = FixedMatrix<FLOAT_TYPE, N, N>::from_matrix(map);
+	auto fixed_right_side =
+		FixedMatrix<FLOAT_TYPE, N, 1>::from_matrix(right_side);
+
+	auto computed_solution = solve_system_of_equations(map, right_side, false);
+	auto dynamic_start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < repetitions; ++i) {
+		do_not_optimize(map);
+		computed_solution = solve_system_of_equations(map, right_side, false);
+		do_not_optimize(computed_solution);
+	}
+	std::chrono::duration<double> dynamic_elapsed =
+		std::chrono::high_resolution_clock::now() - dynamic_start;
+
+	auto fixed_solution =
+		solve_system_of_equations(fixed_map, fixed_right_side);
+	auto fixed_start = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < repetitions; ++i) {
+		do_not_optimize(fixed_map);
+		fixed_solution = solve_system_of_equations(fixed_map, fixed_right_side);
+		do_not_optimize(fixed_solution);
+	}
+	std::chrono::duration<double> fixed_elapsed =
+		std::chrono::high_resolution_clock::now() - fixed_start;
+
+	std::cout << N << ", " << get_error(expected_solution, computed_solution)
+			  << ", "
+			  << abs(
+					 FixedMatrix<FLOAT_TYPE, N, 1>::from_matrix(
+						 expected_solution
+					 ) -
+					 fixed_solution
+				 )
+			  << ", " << dynamic_elapsed.count() << ", "
+			  << fixed_elapsed.count() << std::endl;
+}
+
+// Measures how fast the workers of every NUMA node read the blocks of rows
+// they own, after the blocks have been placed on their nodes. The values are
+// summed as integers, which the compiler can vectorize and reorder, so that
+// the loop is bound by the loads rather than by the latency of the adds.
+void measure_node_bandwidth(size_t bytes, size_t repetitions) {
+	// One page per row
+	constexpr size_t row_length = 4096 / sizeof(uint64_t);
+	const size_t number_of_rows = std::max<size_t>(
+		bytes / (row_length * sizeof(uint64_t)), OWNED_ROW_BLOCK_SIZE
+	);
+
+	// Left uninitialized, so that the pages are only touched by their owners,
+	// and page aligned, so that every row is a page of its own
+	MatrixStorage<uint64_t> data(number_of_rows * row_length);
+	place_owned_row_blocks(data.data(), number_of_rows, row_length);
+	for_each_owned_row_block(
+		0,
+		number_of_rows,
+		[&data](size_t start_row, size_t end_row, size_t) {
+			std::fill(
+				&data[start_row * row_length], &data[end_row * row_length], 1
+			);
+		}
+	);
+
+	ThreadPool &pool = ThreadPool::shared();
+	const size_t number_of_threads = pool.get_number_of_threads();
+	std::vector<double> best_times(
+		number_of_threads, std::numeric_limits<double>::max()
+	);
+	std::vector<size_t> read_bytes(number_of_threads, 0);
+	for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+		// Every worker sweeps the blocks for_each_owned_row_block gives it
+		// and is timed once for the whole sweep
+		pool.run(number_of_threads, [&](size_t thread_index) {
+			auto start = std::chrono::high_resolution_clock::now();
+			uint64_t sum = 0;
+			size_t bytes_read = 0;
+			for (size_t block = thread_index;
+				 block * OWNED_ROW_BLOCK_SIZE < number_of_rows;
+				 block += number_of_threads) {
+				const size_t start_index =
+					block * OWNED_ROW_BLOCK_SIZE * row_length;
+				const size_t end_index =
+					std::min((block + 1) * OWNED_ROW_BLOCK_SIZE, number_of_rows) *
+					row_length;
+				for (size_t i = start_index; i < end_index; ++i) {
+					sum += data[i];
+				}
+				bytes_read += (end_index - start_index) * sizeof(uint64_t);
+			}
+			do_not_optimize(sum);
+			std::chrono::duration<double> elapsed =
+				std::chrono::high_resolution_clock::now() - start;
+			best_times[thread_index] =
+				std::min(best_times[thread_index], elapsed.count());
+			read_bytes[thread_index] = bytes_read;
+		});
+	}
+
+	// The workers of a node read at the same time, so the node is as fast as
+	// its slowest worker
+	std::map<int, std::pair<size_t, double>> nodes;
+	for (size_t i = 0; i < pool.get_number_of_threads(); ++i) {
+		auto &node = nodes[pool.get_worker_node(i)];
+		node.first += read_bytes[i];
+		node.second = std::max(node.second, best_times[i]);
+	}
+	for (const auto &[node, measurement] : nodes) {
+		std::cout << node << ", " << measurement.first << ", "
+				  << measurement.first / measurement.second / 1e9 << std::endl;
+	}
+}
+
+template <size_t... Sizes>
+void benchmark_fixed_sizes(
+	MatrixType matrix_type,
+	size_t repetitions,
+	uint64_t seed,
+	std::index_sequence<Sizes...>
 ) {
-	get_matrix_of_type(matrix_type, size).get_determinant(method);
+	(benchmark_fixed_size<Sizes + 1>(matrix_type, repetitions, seed), ...);
 }
 
 void handle_complexity_task(
@@ -176,42 +624,190 @@ void handle_complexity_task(
 	const std::string &method,
 	const size_t start_size,
 	const size_t step_size,
-	const size_t stop_size
+	const size_t stop_size,
+	bool huge_pages,
+	BackSubstitutionMethod back_substitution_method,
+	MultiplicationMethod multiplication_method,
+	bool verify,
+	uint64_t seed
 ) {
-	std::function<void(size_t)> task_function;
+	// Returns the accuracy estimate of the tasks that solve a system
+	std::function<std::optional<AccuracyEstimate<FLOAT_TYPE>>(size_t)>
+		task_function;
 	switch (task) {
 	case ComplexityTask::SystemOfEquations: {
-		task_function = [method, matrix_type](size_t i) {
-			solve_system(matrix_type, i, string_to_parallel(method));
+		task_function = [method,
+						 matrix_type,
+						 back_substitution_method,
+						 multiplication_method,
+						 verify,
+						 seed](size_t i) {
+			return solve_system(
+				matrix_type,
+				i,
+				string_to_parallel(method),
+				back_substitution_method,
+				multiplication_method,
+				verify,
+				seed
+			);
 		};
 		break;
 	}
 	case ComplexityTask::MatrixEquation: {
-		task_function = [method, matrix_type](size_t i) {
-			solve_matrix_equation(matrix_type, i, string_to_parallel(method));
+		task_function = [method,
+						 matrix_type,
+						 back_substitution_method,
+						 multiplication_method,
+						 verify,
+						 seed](size_t i) {
+			return solve_matrix_equation(
+				matrix_type,
+				i,
+				string_to_parallel(method),
+				back_substitution_method,
+				multiplication_method,
+				verify,
+				seed
+			);
 		};
 		break;
 	}
 	case ComplexityTask::Determinant: {
-		task_function = [method, matrix_type](size_t i) {
+		task_function = [method, matrix_type, seed](size_t i) {
 			compute_determinant(
-				matrix_type, i, string_to_determinant_method(method)
+				matrix_type, i, string_to_determinant_method(method), seed
+			);
+			return std::optional<AccuracyEstimate<FLOAT_TYPE>>();
+		};
+		break;
+	}
+	case ComplexityTask::Multiplication: {
+		task_function = [method, matrix_type, seed](size_t i) {
+			multiply_matrices(
+				matrix_type, i, string_to_multiplication_method(method), seed
 			);
+			return std::optional<AccuracyEstimate<FLOAT_TYPE>>();
 		};
 		break;
 	}
 	}
 
+	// All matrices of a step, including the solver scratch, are allocated
+	// from the arena and released at once before the next step
+	ArenaMemoryResource arena(huge_pages);
 	for (size_t i = start_size; i < stop_size; i += step_size) {
 		std::cout << i << ", ";
+		long page_faults = get_number_of_page_faults();
 		auto start = std::chrono::high_resolution_clock::now();
-		task_function(i);
+		std::optional<AccuracyEstimate<FLOAT_TYPE>> accuracy;
+		{
+			DefaultResourceGuard guard(&arena);
+			accuracy = task_function(i);
+		}
 		std::chrono::duration<double> elapsed =
 			std::chrono::high_resolution_clock::now() - start;
-		std::cout << elapsed.count() << std::endl;
+		page_faults = get_number_of_page_faults() - page_faults;
+		std::cout << elapsed.count() << ", " << page_faults << ", "
+				  << arena.get_allocation_time();
+		if (accuracy.has_value()) {
+			std::cout << ", " << accuracy->condition_number << ", "
+					  << accuracy->forward_error_bound;
+		}
+		std::cout << std::endl;
+		arena.reset();
 	}
 }
 
+// Raised by SIGINT and SIGTERM to stop serving
+std::atomic<bool> stop_serving{false};
+
+void handle_stop_signal(int) { stop_serving = true; }
+
+/*
+ * Runs the jobs of a file through the asynchronous API, one per line:
+ *   solve <matrix_file> <right_side_file> <solution_file>
+ *   invert <matrix_file> <inverse_file>
+ *   determinant <matrix_file>
+ * All of them are submitted at once and then waited for in order, so the
+ * matrices of one job are read and written while another one is computed.
+ * A failed job is reported and does not stop the others. Returns whether all
+ * jobs succeeded.
+ */
+bool run_batch(const std::string &jobs_file_path, bool parallel, bool binary) {
+	std::ifstream file(jobs_file_path);
+	if (!file) {
+		throw std::runtime_error("Could not open " + jobs_file_path);
+	}
+
+	std::vector<std::vector<std::string>> jobs;
+	std::string line;
+	while (std::getline(file, line)) {
+		std::stringstream line_stream(line);
+		std::vector<std::string> job;
+		std::string word;
+		while (line_stream >> word) {
+			job.push_back(word);
+		}
+		if (job.empty() || job[0][0] == '#') {
+			continue;
+		}
+
+		static const std::unordered_map<std::string, size_t> job_lengths = {
+			{"solve", 4}, {"invert", 3}, {"determinant", 2}
+		};
+		auto length = job_lengths.find(job[0]);
+		if (length == job_lengths.end()) {
+			throw std::runtime_error("Unknown job: " + job[0]);
+		}
+		if (job.size() != length->second) {
+			throw std::runtime_error("Wrong number of arguments: " + line);
+		}
+		jobs.push_back(job);
+	}
+
+	// Only the last future of every job is kept, so the matrices are freed
+	// as soon as the job is done with them
+	std::vector<std::function<void()>> results;
+	for (const auto &job : jobs) {
+		auto map = load_matrix_async<FLOAT_TYPE>(job[1]);
+		if (job[0] == "solve") {
+			auto right_side = load_matrix_async<FLOAT_TYPE>(job[2]);
+			auto solution =
+				solve_system_of_equations_async(map, right_side, parallel);
+			auto saved = save_matrix_async(solution, job[3], binary);
+			results.push_back([saved]() { saved.get(); });
+		} else if (job[0] == "invert") {
+			auto inverse = get_inverse_async(map, parallel);
+			auto saved = save_matrix_async(inverse, job[2], binary);
+			results.push_back([saved]() { saved.get(); });
+		} else {
+			auto determinant = get_determinant_async(
+				map,
+				parallel ? DeterminantMethod::ParallelElimination
+						 : DeterminantMethod::Elimination
+			);
+			results.push_back([determinant]() {
+				// Waited for before printing, so a failed job prints nothing
+				const double value = determinant.get();
+				std::cout << "Determinant: " << value << std::endl;
+			});
+		}
+	}
+
+	bool succeeded = true;
+	for (size_t job = 0; job < results.size(); ++job) {
+		try {
+			results[job]();
+		} catch (const std::exception &exception) {
+			std::cerr << "Job " << job + 1 << " failed: " << exception.what()
+					  << std::endl;
+			succeeded = false;
+		}
+	}
+	return succeeded;
+}
+
 int main(int argc, char *argv[]) {
 	if (argc < 2) {
 		throw std::runtime_error(NOT_ENOUGH_ARGS);
@@ -226,6 +822,12 @@ int main(int argc, char *argv[]) {
 		break;
 	}
 	case Command::Generate: {
+		bool binary = take_flag(argc, argv, "--binary");
+		uint64_t seed = take_seed(argc, argv);
+		if (argc < 3) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
 		switch (string_to_matrix_type(argv[2])) {
 		case MatrixType::Random: {
 			if (argc < 8) {
@@ -238,10 +840,10 @@ int main(int argc, char *argv[]) {
 			FLOAT_TYPE max = std::stod(argv[6]);
 			std::string file_path = argv[7];
 
-			Matrix<FLOAT_TYPE>::random(
-				number_of_rows, number_of_columns, min, max
+			MatrixGenerator<FLOAT_TYPE>::random(
+				number_of_rows, number_of_columns, min, max, seed
 			)
-				.save_to_file(file_path);
+				.write_to_file(file_path, binary);
 			break;
 		}
 		case MatrixType::Ones: {
@@ -253,8 +855,8 @@ int main(int argc, char *argv[]) {
 			size_t number_of_columns = std::stoi(argv[4]);
 			std::string file_path = argv[5];
 
-			Matrix<FLOAT_TYPE>::ones(number_of_rows, number_of_columns)
-				.save_to_file(file_path);
+			MatrixGenerator<FLOAT_TYPE>::ones(number_of_rows, number_of_columns)
+				.write_to_file(file_path, binary);
 			break;
 		}
 		case MatrixType::Identity: {
@@ -265,7 +867,9 @@ int main(int argc, char *argv[]) {
 			size_t size = std::stoi(argv[3]);
 			std::string file_path = argv[4];
 
-			Matrix<FLOAT_TYPE>::identity(size).save_to_file(file_path);
+			MatrixGenerator<FLOAT_TYPE>::identity(size).write_to_file(
+				file_path, binary
+			);
 			break;
 		}
 		case MatrixType::Hilbert: {
@@ -276,7 +880,56 @@ int main(int argc, char *argv[]) {
 			size_t size = std::stoi(argv[3]);
 			std::string file_path = argv[4];
 
-			Matrix<FLOAT_TYPE>::hilbert(size).save_to_file(file_path);
+			MatrixGenerator<FLOAT_TYPE>::hilbert(size).write_to_file(
+				file_path, binary
+			);
+			break;
+		}
+		case MatrixType::DiagonallyDominant: {
+			if (argc < 7) {
+				throw std::runtime_error(NOT_ENOUGH_ARGS);
+			}
+
+			size_t size = std::stoi(argv[3]);
+			FLOAT_TYPE min = std::stod(argv[4]);
+			FLOAT_TYPE max = std::stod(argv[5]);
+			std::string file_path = argv[6];
+
+			MatrixGenerator<FLOAT_TYPE>::diagonally_dominant(
+				size, min, max, seed
+			)
+				.write_to_file(file_path, binary);
+			break;
+		}
+		case MatrixType::SymmetricPositiveDefinite: {
+			if (argc < 7) {
+				throw std::runtime_error(NOT_ENOUGH_ARGS);
+			}
+
+			size_t size = std::stoi(argv[3]);
+			FLOAT_TYPE min = std::stod(argv[4]);
+			FLOAT_TYPE max = std::stod(argv[5]);
+			std::string file_path = argv[6];
+
+			MatrixGenerator<FLOAT_TYPE>::symmetric_positive_definite(
+				size, min, max, seed
+			)
+				.write_to_file(file_path, binary);
+			break;
+		}
+		case MatrixType::Banded: {
+			if (argc < 8) {
+				throw std::runtime_error(NOT_ENOUGH_ARGS);
+			}
+
+			size_t size = std::stoi(argv[3]);
+			size_t bandwidth = std::stoi(argv[4]);
+			FLOAT_TYPE min = std::stod(argv[5]);
+			FLOAT_TYPE max = std::stod(argv[6]);
+			std::string file_path = argv[7];
+
+			MatrixGenerator<FLOAT_TYPE>::banded(size, bandwidth, min, max, seed)
+				.write_to_file(file_path, binary);
 			break;
 		}
 		}
@@ -284,6 +937,15 @@ int main(int argc, char *argv[]) {
 		break;
 	}
 	case Command::Solve: {
+		auto memory_limit = take_option(argc, argv, "--memory-limit");
+		auto cache = take_cache(argc, argv);
+		auto back_substitution_method = take_back_substitution_method(argc, argv);
+		if (back_substitution_method == BackSubstitutionMethod::Jordan &&
+			(memory_limit.has_value() || cache.has_value())) {
+			throw std::runtime_error(
+				"--jordan cannot be combined with --cache or --memory-limit!"
+			);
+		}
 		if (argc < 6) {
 			throw std::runtime_error(NOT_ENOUGH_ARGS);
 		}
@@ -293,14 +955,170 @@ int main(int argc, char *argv[]) {
 		auto right_side_file_path = argv[4];
 		auto solution_file_path = argv[5];
 
+		auto right_side = Matrix<FLOAT_TYPE>::from_file(right_side_file_path);
+		if (memory_limit.has_value()) {
+			if (cache.has_value()) {
+				throw std::runtime_error(
+					"--cache cannot be combined with --memory-limit!"
+				);
+			}
+
+			auto solution = solve_system_of_equations_out_of_core(
+				map_file_path,
+				right_side,
+				string_to_bytes(*memory_limit),
+				parallel
+			);
+			solution.save_to_file(solution_file_path);
+			break;
+		}
+
+		auto map = Matrix<FLOAT_TYPE>::from_file(map_file_path);
+		if (cache.has_value()) {
+			auto factorization = cache->get_factorization(map, parallel);
+			auto solution = factorization.solve(right_side, parallel);
+			solution.save_to_file(solution_file_path);
+			print_accuracy_estimate(
+				factorization.estimate_accuracy(map.get_one_norm())
+			);
+			print_cache_statistics(*cache);
+			break;
+		}
+
+		auto estimated_solution = solve_system_of_equations_with_estimate(
+			map, right_side, parallel, back_substitution_method
+		);
+		estimated_solution.solution.save_to_file(solution_file_path);
+		print_accuracy_estimate(estimated_solution.accuracy);
+
+		break;
+	}
+	case Command::SolveBatch: {
+		if (argc < 5) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		auto parallel = string_to_parallel(argv[2]);
+		auto batch_file_path = argv[3];
+		auto solution_file_path = argv[4];
+
+		// Every system is stored as the rows of its augmented matrix, so the
+		// size of the systems follows from the number of columns
+		auto batch = Matrix<FLOAT_TYPE>::from_file(batch_file_path);
+		if (batch.get_number_of_columns() < 2 ||
+			batch.get_number_of_rows() % (batch.get_number_of_columns() - 1)) {
+			throw std::runtime_error("The batch file has the wrong shape!");
+		}
+
+		size_t size = batch.get_number_of_columns() - 1;
+		std::vector<FLOAT_TYPE> maps;
+		std::vector<FLOAT_TYPE> right_sides;
+		maps.reserve(batch.get_number_of_rows() * size);
+		right_sides.reserve(batch.get_number_of_rows());
+		for (size_t row = 0; row < batch.get_number_of_rows(); ++row) {
+			for (size_t column = 0; column < size; ++column) {
+				maps.push_back(batch.at(row, column));
+			}
+			right_sides.push_back(batch.at(row, size));
+		}
+
+		auto solutions =
+			solve_batched_systems_of_equations(maps, right_sides, size, parallel);
+		solutions.save_to_file(solution_file_path);
+
+		break;
+	}
+	case Command::SolveUpdated: {
+		auto cache = take_cache(argc, argv);
+		if (argc < 8) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		auto parallel = string_to_parallel(argv[2]);
+		auto map_file_path = argv[3];
+		auto u_file_path = argv[4];
+		auto v_file_path = argv[5];
+		auto right_side_file_path = argv[6];
+		auto solution_file_path = argv[7];
+
 		auto map = Matrix<FLOAT_TYPE>::from_file(map_file_path);
+		RankUpdate<FLOAT_TYPE> update{
+			Matrix<FLOAT_TYPE>::from_file(u_file_path),
+			Matrix<FLOAT_TYPE>::from_file(v_file_path)
+		};
 		auto right_side = Matrix<FLOAT_TYPE>::from_file(right_side_file_path);
-		auto solution = solve_system_of_equations(map, right_side, parallel);
+
+		// The factorization of the original map is what is worth caching,
+		// since it stays the same while the updates change
+		auto factorization =
+			cache.has_value()
+				? cache->get_factorization(map, parallel)
+				: LuFactorization<FLOAT_TYPE>::factorize(map, parallel);
+		LowRankUpdate<FLOAT_TYPE> updated_factorization(
+			map, factorization, update, parallel
+		);
+		auto solution = updated_factorization.solve(right_side, parallel);
 		solution.save_to_file(solution_file_path);
 
+		std::cout << "Determinant: " << updated_factorization.get_determinant()
+				  << std::endl;
+		std::cout << "Refactored: "
+				  << (updated_factorization.was_refactored() ? "yes" : "no")
+				  << std::endl;
+		if (cache.has_value()) {
+			print_cache_statistics(*cache);
+		}
+		break;
+	}
+	case Command::DistributedSolve: {
+		auto block_size = take_option(argc, argv, "--block-size");
+		if (argc < 7) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		size_t number_of_processes = std::stoi(argv[2]);
+		auto transport_type = string_to_transport_type(argv[3]);
+		auto map = Matrix<FLOAT_TYPE>::from_file(argv[4]);
+		auto right_side = Matrix<FLOAT_TYPE>::from_file(argv[5]);
+		auto solution_file_path = argv[6];
+
+		auto result = solve_system_of_equations_distributed(
+			map,
+			right_side,
+			number_of_processes,
+			transport_type,
+			block_size.has_value() ? std::stoul(*block_size)
+								   : DISTRIBUTED_BLOCK_SIZE
+		);
+		result.solution.save_to_file(solution_file_path);
+
+		for (size_t rank = 0; rank < result.statistics.size(); ++rank) {
+			const auto &statistics = result.statistics[rank];
+			std::cout << rank << ", " << statistics.compute_time << ", "
+					  << statistics.communication_time << ", "
+					  << statistics.bytes_sent << std::endl;
+		}
+		break;
+	}
+	case Command::Batch: {
+		bool binary = take_flag(argc, argv, "--binary");
+		if (argc < 4) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		auto parallel = string_to_parallel(argv[2]);
+		if (!run_batch(argv[3], parallel, binary)) {
+			return 1;
+		}
 		break;
 	}
 	case Command::Invert: {
+		auto cache = take_cache(argc, argv);
+		auto back_substitution_method = take_back_substitution_method(argc, argv);
+		if (back_substitution_method == BackSubstitutionMethod::Jordan &&
+			cache.has_value()) {
+			throw std::runtime_error("--jordan cannot be combined with --cache!");
+		}
 		if (argc < 5) {
 			throw std::runtime_error(NOT_ENOUGH_ARGS);
 		}
@@ -309,13 +1127,22 @@ int main(int argc, char *argv[]) {
 		auto matrix_file_path = argv[3];
 		auto solution_file_path = argv[4];
 
-		auto solution =
-			Matrix<FLOAT_TYPE>::from_file(matrix_file_path).get_inverse();
+		auto matrix = Matrix<FLOAT_TYPE>::from_file(matrix_file_path);
+		if (cache.has_value()) {
+			auto solution =
+				cache->get_factorization(matrix, parallel).get_inverse(parallel);
+			solution.save_to_file(solution_file_path);
+			print_cache_statistics(*cache);
+			break;
+		}
+
+		auto solution = matrix.get_inverse(parallel, back_substitution_method);
 		solution.save_to_file(solution_file_path);
 
 		break;
 	}
 	case Command::Determinant: {
+		auto cache = take_cache(argc, argv);
 		if (argc < 4) {
 			throw std::runtime_error(NOT_ENOUGH_ARGS);
 		}
@@ -324,12 +1151,39 @@ int main(int argc, char *argv[]) {
 		auto file_path = argv[3];
 
 		auto matrix = Matrix<FLOAT_TYPE>::from_file(file_path);
+		if (cache.has_value()) {
+			if (method == DeterminantMethod::Definition) {
+				throw std::runtime_error(
+					"The cache can only be used with elimination!"
+				);
+			}
+
+			auto determinant =
+				cache
+					->get_factorization(
+						matrix, method == DeterminantMethod::ParallelElimination
+					)
+					.get_determinant();
+			std::cout << "Determinant: " << determinant << std::endl;
+			print_cache_statistics(*cache);
+			break;
+		}
+
 		auto determinant = matrix.get_determinant(method);
 
 		std::cout << "Determinant: " << determinant << std::endl;
 		break;
 	}
 	case Command::Complexity: {
+		bool huge_pages = take_flag(argc, argv, "--huge-pages");
+		bool verify = !take_flag(argc, argv, "--skip-verification");
+		auto multiplication = take_option(argc, argv, "--multiplication");
+		MultiplicationMethod multiplication_method =
+			multiplication.has_value()
+				? string_to_multiplication_method(*multiplication)
+				: MultiplicationMethod::Classical;
+		auto back_substitution_method = take_back_substitution_method(argc, argv);
+		uint64_t seed = take_seed(argc, argv);
 		if (argc < 8) {
 			throw std::runtime_error(NOT_ENOUGH_ARGS);
 		}
@@ -342,7 +1196,67 @@ int main(int argc, char *argv[]) {
 		size_t stop_size = std::stoi(argv[7]);
 
 		handle_complexity_task(
-			task, matrix_type, method, start_size, step_size, stop_size
+			task,
+			matrix_type,
+			method,
+			start_size,
+			step_size,
+			stop_size,
+			huge_pages,
+			back_substitution_method,
+			multiplication_method,
+			verify,
+			seed
+		);
+		break;
+	}
+	case Command::Serve: {
+		auto socket_path = take_option(argc, argv, "--socket");
+
+		// A client that goes away must not take the service down with it
+		std::signal(SIGPIPE, SIG_IGN);
+
+		std::vector<double> statistics;
+		if (socket_path.has_value()) {
+			std::signal(SIGINT, handle_stop_signal);
+			std::signal(SIGTERM, handle_stop_signal);
+			statistics =
+				serve_unix_socket<FLOAT_TYPE>(*socket_path, stop_serving);
+		} else {
+			statistics = serve_standard_streams<FLOAT_TYPE>();
+		}
+
+		std::cerr << "Requests: " << statistics[0]
+				  << ", latency p50: " << statistics[1]
+				  << ", p90: " << statistics[2] << ", p99: " << statistics[3]
+				  << ", max: " << statistics[4] << std::endl;
+		break;
+	}
+	case Command::NumaBandwidth: {
+		if (argc < 4) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		size_t bytes = string_to_bytes(argv[2]);
+		size_t repetitions = std::stoi(argv[3]);
+
+		measure_node_bandwidth(bytes, repetitions);
+		break;
+	}
+	case Command::BenchmarkFixed: {
+		uint64_t seed = take_seed(argc, argv);
+		if (argc < 4) {
+			throw std::runtime_error(NOT_ENOUGH_ARGS);
+		}
+
+		MatrixType matrix_type = string_to_matrix_type(argv[2]);
+		size_t repetitions = std::stoi(argv[3]);
+
+		benchmark_fixed_sizes(
+			matrix_type,
+			repetitions,
+			seed,
+			std::make_index_sequence<FIXED_UNROLL_LIMIT>{}
 		);
 		break;
 	}
@@ -0,0 +1,135 @@
+#include "checks.hpp"
+
+#include "../src/core/async_solver.hpp"
+
+#include <atomic>
+
+// Enough jobs for loading, solving and saving to overlap
+constexpr size_t ASYNC_NUMBER_OF_JOBS = 12;
+const std::vector<size_t> ASYNC_SIZES = {1, 7, 65};
+
+template <typename T>
+static std::shared_future<T> get_ready_future(const T &value) {
+	std::promise<T> promise;
+	promise.set_value(value);
+	return promise.get_future().share();
+}
+
+void check_async_solver() {
+	TemporaryDirectory directory;
+
+	for (size_t size : ASYNC_SIZES) {
+		const std::string name = "async solve of " + std::to_string(size);
+		std::vector<Matrix<double>> maps;
+		std::vector<Matrix<double>> right_sides;
+		std::vector<std::shared_future<void>> saved;
+		for (size_t job = 0; job < ASYNC_NUMBER_OF_JOBS; ++job) {
+			const std::string prefix =
+				(directory.get_path() / std::to_string(job)).string();
+			maps.push_back(
+				Matrix<double>::random(size, CHECK_MIN, CHECK_MAX, 2 * job)
+			);
+			right_sides.push_back(Matrix<double>::random(
+				size, 2, CHECK_MIN, CHECK_MAX, 2 * job + 1
+			));
+			maps.back().save_to_file(prefix + "-map", true);
+			right_sides.back().save_to_file(prefix + "-right-side", true);
+
+			saved.push_back(save_matrix_async(
+				solve_system_of_equations_async(
+					load_matrix_async<double>(prefix + "-map"),
+					load_matrix_async<double>(prefix + "-right-side")
+				),
+				prefix + "-solution",
+				true
+			));
+		}
+
+		for (size_t job = 0; job < ASYNC_NUMBER_OF_JOBS; ++job) {
+			saved[job].get();
+			check(
+				are_bitwise_identical(
+					Matrix<double>::from_file(
+						(directory.get_path() / std::to_string(job)).string() +
+						"-solution"
+					),
+					solve_system_of_equations(maps[job], right_sides[job])
+				),
+				name + ": the solution of job " + std::to_string(job) +
+					" differs from GEM"
+			);
+		}
+
+		auto map = get_ready_future(maps.front());
+		check(
+			are_bitwise_identical(
+				get_inverse_async(map).get(), maps.front().get_inverse()
+			),
+			name + ": the inverse differs"
+		);
+		check(
+			get_determinant_async(map).get() ==
+				maps.front().get_determinant(),
+			name + ": the determinant differs"
+		);
+	}
+
+	// A failure is passed on to every operation depending on it
+	auto singular_solution = solve_system_of_equations_async(
+		get_ready_future(get_singular_matrix()),
+		get_ready_future(Matrix<double>::ones(3, 1))
+	);
+	auto singular_saved = save_matrix_async(
+		singular_solution, (directory.get_path() / "singular").string()
+	);
+	check_throws(
+		[&]() { singular_solution.get(); },
+		"The matrix is singular!",
+		"async solve of a singular map"
+	);
+	check_throws(
+		[&]() { singular_saved.get(); },
+		"The matrix is singular!",
+		"async save of the solution of a singular map"
+	);
+	check(
+		!std::filesystem::exists(directory.get_path() / "singular"),
+		"async save of the solution of a singular map: a file is written"
+	);
+
+	auto missing_map =
+		load_matrix_async<double>((directory.get_path() / "missing").string());
+	auto missing_solution = solve_system_of_equations_async(
+		missing_map, get_ready_future(Matrix<double>::ones(3, 1))
+	);
+	bool missing_map_failed = false;
+	try {
+		missing_map.get();
+	} catch (const std::exception &exception) {
+		missing_map_failed = true;
+		check_throws(
+			[&]() { missing_solution.get(); },
+			exception.what(),
+			"async solve of a map that cannot be loaded"
+		);
+	}
+	check(
+		missing_map_failed, "async load of a missing file: no exception thrown"
+	);
+
+	// An executor finishes the tasks submitted before it is destroyed
+	std::atomic<size_t> finished_tasks{0};
+	{
+		AsyncExecutor executor(1);
+		for (size_t task = 0; task < ASYNC_NUMBER_OF_JOBS; ++task) {
+			executor.submit(
+				task % 2 == 0 ? AsyncLane::Compute : AsyncLane::Io,
+				[&finished_tasks]() { ++finished_tasks; }
+			);
+		}
+	}
+	check(
+		finished_tasks == ASYNC_NUMBER_OF_JOBS,
+		"async executor: not every task is finished when it is destroyed"
+	);
+}
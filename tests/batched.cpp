@@ -0,0 +1,145 @@
+#include "checks.hpp"
+
+#include "../src/core/batched_system_of_equations.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+// Sizes of the systems and numbers of them around a pack of lanes
+const std::vector<size_t> BATCHED_SIZES = {1, 2, 5, 16};
+const std::vector<size_t> BATCHED_NUMBERS_OF_SYSTEMS = {1, 7, 8, 9, 100};
+constexpr double BATCHED_TOLERANCE = 1e-9;
+
+// A batch of seeded systems stored like the batched solver takes them
+struct Batch {
+	std::vector<Matrix<double>> maps;
+	std::vector<Matrix<double>> right_sides;
+	std::vector<double> map_values;
+	std::vector<double> right_side_values;
+
+	void add(const Matrix<double> &map, const Matrix<double> &right_side) {
+		const size_t size = map.get_number_of_rows();
+		for (size_t row = 0; row < size; ++row) {
+			for (size_t column = 0; column < size; ++column) {
+				this->map_values.push_back(map.at(row, column));
+			}
+			this->right_side_values.push_back(right_side.at(row, 0));
+		}
+		this->maps.push_back(map);
+		this->right_sides.push_back(right_side);
+	}
+};
+
+static Matrix<double>
+get_row(const Matrix<double> &matrix, size_t row, size_t size) {
+	std::vector<double> values(size);
+	for (size_t column = 0; column < size; ++column) {
+		values[column] = matrix.at(row, column);
+	}
+	return Matrix<double>(values, size, 1);
+}
+
+void check_batched() {
+	for (size_t size : BATCHED_SIZES) {
+		for (size_t number_of_systems : BATCHED_NUMBERS_OF_SYSTEMS) {
+			const std::string name = "batched solve of " +
+									 std::to_string(number_of_systems) +
+									 " systems of " + std::to_string(size);
+			Batch batch;
+			for (size_t system = 0; system < number_of_systems; ++system) {
+				batch.add(
+					Matrix<double>::random(size, CHECK_MIN, CHECK_MAX, system),
+					Matrix<double>::random(
+						size, 1, CHECK_MIN, CHECK_MAX, system + 1000
+					)
+				);
+			}
+
+			auto solutions = solve_batched_systems_of_equations(
+				batch.map_values, batch.right_side_values, size
+			);
+			check(
+				are_bitwise_identical(
+					solutions,
+					solve_batched_systems_of_equations(
+						batch.map_values, batch.right_side_values, size, false
+					)
+				),
+				name + ": the sequential solutions differ"
+			);
+			for (size_t system = 0; system < number_of_systems; ++system) {
+				check(
+					get_relative_error(
+						get_row(solutions, system, size),
+						solve_system_of_equations(
+							batch.maps[system], batch.right_sides[system]
+						)
+					) < BATCHED_TOLERANCE,
+					name + ": system " + std::to_string(system) +
+						" differs from GEM"
+				);
+			}
+		}
+	}
+
+	// Singular systems in both packs, between regular ones
+	auto is_singular_system = [](size_t system) {
+		return system == 2 || system == 9;
+	};
+	Batch batch;
+	for (size_t system = 0; system < 12; ++system) {
+		batch.add(
+			is_singular_system(system)
+				? get_singular_matrix()
+				: Matrix<double>::random(3, CHECK_MIN, CHECK_MAX, system),
+			Matrix<double>::ones(3, 1)
+		);
+	}
+	for (bool parallel : {true, false}) {
+		auto batched_solution =
+			solve_batched_systems_of_equations_with_singular_flags(
+				batch.map_values, batch.right_side_values, 3, parallel
+			);
+		for (size_t system = 0; system < 12; ++system) {
+			const std::string name =
+				"batched solve of singular systems: system " +
+				std::to_string(system);
+			auto solution = get_row(batched_solution.solutions, system, 3);
+			if (is_singular_system(system)) {
+				check(
+					batched_solution.singular[system] && abs(solution) == 0,
+					name + ": is not flagged with a zero solution"
+				);
+				continue;
+			}
+
+			check(
+				!batched_solution.singular[system] &&
+					get_relative_error(
+						solution,
+						solve_system_of_equations(
+							batch.maps[system], batch.right_sides[system]
+						)
+					) < BATCHED_TOLERANCE,
+				name + ": is flagged or differs from GEM"
+			);
+		}
+	}
+	check_throws(
+		[&]() {
+			solve_batched_systems_of_equations(
+				batch.map_values, batch.right_side_values, 3
+			);
+		},
+		"System 2 of the batch is singular!",
+		"batched solve of singular systems"
+	);
+
+	check_throws(
+		[]() {
+			solve_batched_systems_of_equations(
+				std::vector<double>(8), std::vector<double>(2), 2
+			);
+		},
+		"The number of right sides does not match the number of maps!",
+		"batched solve with too few right sides"
+	);
+}
@@ -0,0 +1,137 @@
+#include "checks.hpp"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+
+#include <unistd.h>
+
+namespace {
+
+size_t number_of_failures = 0;
+size_t number_of_temporary_directories = 0;
+
+} // namespace
+
+TemporaryDirectory::TemporaryDirectory()
+	: path(
+		  std::filesystem::temp_directory_path() /
+		  ("gem-checks-" + std::to_string(getpid()) + "-" +
+		   std::to_string(number_of_temporary_directories++))
+	  ) {
+	std::filesystem::create_directories(this->path);
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+	std::error_code error;
+	std::filesystem::remove_all(this->path, error);
+}
+
+void check(bool condition, const std::string &description) {
+	if (!condition) {
+		std::cerr << "FAILED: " << description << std::endl;
+		++number_of_failures;
+	}
+}
+
+void check_throws(
+	const std::function<void()> &function,
+	const std::string &message,
+	const std::string &description
+) {
+	try {
+		function();
+	} catch (const std::runtime_error &error) {
+		check(
+			error.what() == message,
+			description + ": threw \"" + error.what() + "\" instead of \"" +
+				message + "\""
+		);
+		return;
+	}
+	check(false, description + ": did not throw \"" + message + "\"");
+}
+
+bool are_bitwise_identical(
+	const Matrix<double> &lhs, const Matrix<double> &rhs
+) {
+	if (lhs.get_number_of_rows() != rhs.get_number_of_rows() ||
+		lhs.get_number_of_columns() != rhs.get_number_of_columns()) {
+		return false;
+	}
+	for (size_t row = 0; row < lhs.get_number_of_rows(); ++row) {
+		for (size_t column = 0; column < lhs.get_number_of_columns();
+			 ++column) {
+			if (std::memcmp(
+					&lhs.at(row, column), &rhs.at(row, column), sizeof(double)
+				) != 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+double
+get_relative_error(const Matrix<double> &matrix, const Matrix<double> &expected) {
+	return abs(matrix - expected) / abs(expected);
+}
+
+const std::vector<TestMatrix> &get_test_matrices() {
+	static const std::vector<TestMatrix> test_matrices = {
+		{"random",
+		 [](size_t size, uint64_t seed) {
+			 return Matrix<double>::random(size, CHECK_MIN, CHECK_MAX, seed);
+		 }},
+		{"diagonally dominant",
+		 [](size_t size, uint64_t seed) {
+			 return MatrixGenerator<double>::diagonally_dominant(
+						size, CHECK_MIN, CHECK_MAX, seed
+			 )
+				 .generate();
+		 }},
+		{"symmetric positive definite",
+		 [](size_t size, uint64_t seed) {
+			 return MatrixGenerator<double>::symmetric_positive_definite(
+						size, CHECK_MIN, CHECK_MAX, seed
+			 )
+				 .generate();
+		 }},
+	};
+	return test_matrices;
+}
+
+Matrix<double> get_singular_matrix() {
+	return Matrix<double>(std::vector<double>{1, 2, 3, 2, 4, 6, 1, 1, 1}, 3, 3);
+}
+
+int main(int argc, char **argv) {
+	const std::map<std::string, std::function<void()>> checks = {
+		{"async_solver", check_async_solver},
+		{"batched", check_batched},
+		{"condition_estimate", check_condition_estimate},
+		{"distributed", check_distributed},
+		{"factorization_cache", check_factorization_cache},
+		{"fixed_matrix", check_fixed_matrix},
+		{"low_rank_update", check_low_rank_update},
+		{"matrix_expression", check_matrix_expression},
+		{"out_of_core", check_out_of_core},
+		{"solver_service", check_solver_service},
+		{"strassen_winograd", check_strassen_winograd},
+		{"triangular_solve", check_triangular_solve},
+	};
+
+	// Only the named check runs if one is given
+	for (const auto &[name, run_check] : checks) {
+		if (argc < 2 || name == argv[1]) {
+			run_check();
+		}
+	}
+
+	if (number_of_failures > 0) {
+		std::cerr << number_of_failures << " checks failed" << std::endl;
+		return 1;
+	}
+	return 0;
+}
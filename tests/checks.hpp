@@ -0,0 +1,78 @@
+#include "../src/core/matrix.hpp"
+#include "../src/core/matrix_generator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifndef CHECKS_H
+#define CHECKS_H
+
+/*
+ * The checks run by gem_checks, one function per part of the solver. A check
+ * records every failed expectation and goes on, gem_checks then exits with a
+ * nonzero status if any of them failed.
+ */
+
+constexpr double CHECK_MIN = -100;
+constexpr double CHECK_MAX = 100;
+
+// A family of seeded test matrices
+struct TestMatrix {
+	std::string name;
+	std::function<Matrix<double>(size_t, uint64_t)> generate;
+};
+
+// A directory for the files of a check, removed with everything in it
+class TemporaryDirectory {
+	private:
+	std::filesystem::path path;
+
+	public:
+	TemporaryDirectory();
+	TemporaryDirectory(const TemporaryDirectory &) = delete;
+	TemporaryDirectory &operator=(const TemporaryDirectory &) = delete;
+	~TemporaryDirectory();
+
+	std::filesystem::path get_path() const { return this->path; }
+};
+
+// Records a failed check if the condition does not hold
+void check(bool condition, const std::string &description);
+
+// Checks that the function throws an std::runtime_error with the message
+void check_throws(
+	const std::function<void()> &function,
+	const std::string &message,
+	const std::string &description
+);
+
+bool are_bitwise_identical(const Matrix<double> &lhs, const Matrix<double> &rhs);
+
+// Get the relative error of the matrix against the expected one
+double
+get_relative_error(const Matrix<double> &matrix, const Matrix<double> &expected);
+
+// Get the random, diagonally dominant and symmetric positive definite families
+const std::vector<TestMatrix> &get_test_matrices();
+
+// Get a singular map: its second row is twice the first one
+Matrix<double> get_singular_matrix();
+
+void check_async_solver();
+void check_batched();
+void check_condition_estimate();
+void check_distributed();
+void check_factorization_cache();
+void check_fixed_matrix();
+void check_low_rank_update();
+void check_matrix_expression();
+void check_out_of_core();
+void check_solver_service();
+void check_strassen_winograd();
+void check_triangular_solve();
+
+#endif
@@ -0,0 +1,75 @@
+#include "checks.hpp"
+
+#include "../src/core/lu_factorization.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+#include <cmath>
+
+const std::vector<size_t> CONDITION_ESTIMATE_SIZES = {1, 2, 7, 64, 131};
+// Headroom for the rounding errors of computing the exact condition number
+constexpr double CONDITION_NUMBER_TOLERANCE = 1e-12;
+
+void check_condition_estimate() {
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : CONDITION_ESTIMATE_SIZES) {
+			const std::string name = "condition estimate of " +
+									 test_matrix.name + " " +
+									 std::to_string(size);
+			auto map = test_matrix.generate(size, size);
+			auto right_side = Matrix<double>::random(
+				size, 2, CHECK_MIN, CHECK_MAX, size + 1
+			);
+
+			auto estimated_solution = solve_system_of_equations_with_estimate(
+				map, right_side, true, BackSubstitutionMethod::Triangular
+			);
+			check(
+				are_bitwise_identical(
+					estimated_solution.solution,
+					solve_system_of_equations(map, right_side)
+				),
+				name + ": the solution differs from GEM"
+			);
+
+			// Hager's method only ever finds a lower bound
+			const double estimate = estimated_solution.accuracy.condition_number;
+			const double condition_number =
+				map.get_one_norm() * map.get_inverse().get_one_norm();
+			check(
+				estimate >= 1 &&
+					estimate <=
+						condition_number * (1 + CONDITION_NUMBER_TOLERANCE),
+				name + ": the estimate " + std::to_string(estimate) +
+					" is not within [1, " + std::to_string(condition_number) +
+					"]"
+			);
+
+			const auto lu_accuracy = LuFactorization<double>::factorize(map)
+										 .estimate_accuracy(map.get_one_norm());
+			check(
+				lu_accuracy.condition_number == estimate &&
+					lu_accuracy.forward_error_bound ==
+						estimated_solution.accuracy.forward_error_bound,
+				name + ": the estimate from the LU factors differs"
+			);
+			check(
+				std::isfinite(estimated_solution.accuracy.forward_error_bound) &&
+					estimated_solution.accuracy.forward_error_bound < 1,
+				name + ": the forward error bound is not below 1"
+			);
+		}
+	}
+
+	// The Hilbert matrix of 12 has a condition number of about 4e16, too
+	// large for any bound on the error
+	auto hilbert = Matrix<double>::hilbert(12);
+	auto hilbert_accuracy =
+		LuFactorization<double>::factorize(hilbert).estimate_accuracy(
+			hilbert.get_one_norm()
+		);
+	check(
+		hilbert_accuracy.condition_number > 1e16 &&
+			std::isinf(hilbert_accuracy.forward_error_bound),
+		"condition estimate of Hilbert 12: the estimate is too small"
+	);
+}
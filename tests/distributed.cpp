@@ -0,0 +1,88 @@
+#include "checks.hpp"
+
+#include "../src/core/distributed_system_of_equations.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+constexpr size_t DISTRIBUTED_RIGHT_SIDES = 3;
+// Sizes around the blocks of the triangular solve
+const std::vector<size_t> DISTRIBUTED_SIZES = {1, 2, 7, 64, 65, 131};
+
+// A grid of processes of one transport and the block size dealt out to it
+struct DistributedSetup {
+	size_t number_of_processes;
+	DistributedTransportType transport_type;
+	size_t block_size;
+	std::string name;
+};
+
+const std::vector<DistributedSetup> DISTRIBUTED_SETUPS = {
+	{1, DistributedTransportType::SharedMemory, 64, "1 process"},
+	{4,
+	 DistributedTransportType::SharedMemory,
+	 8,
+	 "4 processes over shared memory"},
+	{3, DistributedTransportType::Socket, 16, "3 processes over tcp"},
+	{6, DistributedTransportType::Socket, 1, "6 processes over tcp"},
+};
+
+// A singular map whose second column has no pivot, which is dealt out to
+// another process than the first one with blocks of one column
+static Matrix<double> get_singular_matrix_without_second_pivot() {
+	return Matrix<double>(std::vector<double>{1, 2, 3, 2, 4, 6, 1, 2, 1}, 3, 3);
+}
+
+void check_distributed() {
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : DISTRIBUTED_SIZES) {
+			auto map = test_matrix.generate(size, size);
+			auto right_side = Matrix<double>::random(
+				size, DISTRIBUTED_RIGHT_SIDES, CHECK_MIN, CHECK_MAX, size + 1
+			);
+			auto solution = solve_system_of_equations(map, right_side);
+
+			for (const auto &setup : DISTRIBUTED_SETUPS) {
+				auto distributed_solution = solve_system_of_equations_distributed(
+					map,
+					right_side,
+					setup.number_of_processes,
+					setup.transport_type,
+					setup.block_size
+				);
+				const std::string name = "distributed solve of " +
+										 test_matrix.name + " " +
+										 std::to_string(size) + " by " +
+										 setup.name;
+				check(
+					are_bitwise_identical(
+						distributed_solution.solution, solution
+					),
+					name + ": the solution differs from GEM"
+				);
+				check(
+					distributed_solution.statistics.size() ==
+						setup.number_of_processes,
+					name + ": the statistics do not cover every process"
+				);
+			}
+		}
+	}
+
+	for (const auto &map :
+		 {get_singular_matrix(), get_singular_matrix_without_second_pivot()}) {
+		for (const auto &setup : DISTRIBUTED_SETUPS) {
+			check_throws(
+				[&]() {
+					solve_system_of_equations_distributed(
+						map,
+						Matrix<double>::ones(3, 1),
+						setup.number_of_processes,
+						setup.transport_type,
+						setup.block_size
+					);
+				},
+				"The matrix is singular!",
+				"distributed solve of a singular map by " + setup.name
+			);
+		}
+	}
+}
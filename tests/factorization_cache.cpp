@@ -0,0 +1,135 @@
+#include "checks.hpp"
+
+#include "../src/core/factorization_cache.hpp"
+
+const std::vector<size_t> FACTORIZATION_CACHE_SIZES = {1, 7, 65};
+constexpr size_t FACTORIZATION_CACHE_SIZE_LIMIT = size_t(1) << 30;
+
+static std::vector<std::filesystem::path>
+get_entry_paths(const std::filesystem::path &directory) {
+	std::vector<std::filesystem::path> paths;
+	for (const auto &entry : std::filesystem::directory_iterator(directory)) {
+		if (entry.path().extension() == FACTORIZATION_FILE_EXTENSION) {
+			paths.push_back(entry.path());
+		}
+	}
+	return paths;
+}
+
+static bool has_statistics(
+	const FactorizationCache &cache,
+	size_t hits,
+	size_t misses,
+	size_t evictions
+) {
+	const auto statistics = cache.get_statistics();
+	return statistics.hits == hits && statistics.misses == misses &&
+		   statistics.evictions == evictions;
+}
+
+void check_factorization_cache() {
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : FACTORIZATION_CACHE_SIZES) {
+			const std::string name = "factorization cache of " +
+									 test_matrix.name + " " +
+									 std::to_string(size);
+			TemporaryDirectory directory;
+			auto map = test_matrix.generate(size, size);
+			auto right_side =
+				Matrix<double>::random(size, 3, CHECK_MIN, CHECK_MAX, size + 1);
+			const auto factorization = LuFactorization<double>::factorize(map);
+			auto solution = factorization.solve(right_side);
+
+			FactorizationCache cache(
+				directory.get_path(), FACTORIZATION_CACHE_SIZE_LIMIT
+			);
+			auto missed = cache.get_factorization(map);
+			check(
+				are_bitwise_identical(missed.solve(right_side), solution),
+				name + ": the solution on a miss differs from LU"
+			);
+			check(
+				get_entry_paths(directory.get_path()).size() == 1,
+				name + ": the factorization is not stored"
+			);
+
+			// Another run that uses the same directory
+			FactorizationCache other_cache(
+				directory.get_path(), FACTORIZATION_CACHE_SIZE_LIMIT
+			);
+			auto hit = other_cache.get_factorization(map);
+			check(
+				are_bitwise_identical(hit.solve(right_side), solution) &&
+					hit.get_determinant() == factorization.get_determinant(),
+				name + ": the solution on a hit differs from LU"
+			);
+			check(
+				has_statistics(cache, 1, 1, 0),
+				name + ": the statistics do not count a miss and a hit"
+			);
+
+			// A truncated and an empty entry are misses that get replaced
+			const auto entry_path = get_entry_paths(directory.get_path())[0];
+			for (size_t entry_size :
+				 {std::filesystem::file_size(entry_path) / 2, size_t(0)}) {
+				std::filesystem::resize_file(entry_path, entry_size);
+				check(
+					are_bitwise_identical(
+						cache.get_factorization(map).solve(right_side), solution
+					),
+					name + ": the solution from a broken entry of " +
+						std::to_string(entry_size) + " bytes differs from LU"
+				);
+			}
+			check(
+				has_statistics(cache, 1, 3, 0) &&
+					std::filesystem::file_size(entry_path) > 0,
+				name + ": the broken entries are not replaced on a miss"
+			);
+		}
+	}
+
+	// Entries over the limit are evicted, the least recently used first
+	TemporaryDirectory directory;
+	auto map = Matrix<double>::random(16, CHECK_MIN, CHECK_MAX, 1);
+	auto other_map = Matrix<double>::random(16, CHECK_MIN, CHECK_MAX, 2);
+	FactorizationCache tiny_cache(directory.get_path(), 1);
+	tiny_cache.get_factorization(map);
+	check(
+		get_entry_paths(directory.get_path()).empty(),
+		"factorization cache over the limit: an entry is stored"
+	);
+	TemporaryDirectory other_directory;
+	FactorizationCache cache(other_directory.get_path(), 4096);
+	cache.get_factorization(map);
+	cache.get_factorization(other_map);
+	cache.get_factorization(other_map);
+	check(
+		has_statistics(cache, 1, 2, 1) &&
+			get_entry_paths(other_directory.get_path()).size() == 1,
+		"factorization cache of two entries: the first one is not evicted"
+	);
+
+	// A singular map fails on both a miss and a hit
+	TemporaryDirectory singular_directory;
+	FactorizationCache singular_cache(
+		singular_directory.get_path(), FACTORIZATION_CACHE_SIZE_LIMIT
+	);
+	for (const std::string access : {"miss", "hit"}) {
+		check_throws(
+			[&]() {
+				singular_cache.get_factorization(get_singular_matrix())
+					.solve(Matrix<double>::ones(3, 1));
+			},
+			"The matrix is singular!",
+			"factorization cache of a singular map on a " + access
+		);
+	}
+	check_throws(
+		[&]() {
+			singular_cache.get_factorization(Matrix<double>::ones(2, 3));
+		},
+		"Cannot factorize a non-square matrix!",
+		"factorization cache of a non-square map"
+	);
+}
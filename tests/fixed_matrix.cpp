@@ -0,0 +1,96 @@
+#include "checks.hpp"
+
+#include "../src/core/fixed_matrix.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+constexpr double FIXED_MATRIX_TOLERANCE = 1e-9;
+
+template <size_t N> static void check_fixed_size() {
+	const std::string name = "fixed matrix of " + std::to_string(N);
+	constexpr size_t right_sides = 3;
+	auto map = Matrix<double>::random(N, CHECK_MIN, CHECK_MAX, N);
+	auto right_side =
+		Matrix<double>::random(N, right_sides, CHECK_MIN, CHECK_MAX, N + 1);
+	auto fixed_map = FixedMatrix<double, N, N>::random(CHECK_MIN, CHECK_MAX, N);
+	auto fixed_right_side = FixedMatrix<double, N, right_sides>::random(
+		CHECK_MIN, CHECK_MAX, N + 1
+	);
+
+	check(
+		are_bitwise_identical(fixed_map.to_matrix(), map) &&
+			are_bitwise_identical(fixed_right_side.to_matrix(), right_side),
+		name + ": the random values differ from the ones of Matrix"
+	);
+	check(
+		get_relative_error(
+			solve_system_of_equations(fixed_map, fixed_right_side).to_matrix(),
+			solve_system_of_equations(map, right_side)
+		) < FIXED_MATRIX_TOLERANCE,
+		name + ": the solution differs from GEM"
+	);
+	check(
+		get_relative_error(
+			fixed_map.get_inverse().to_matrix(), map.get_inverse()
+		) < FIXED_MATRIX_TOLERANCE,
+		name + ": the inverse differs"
+	);
+	check(
+		std::abs(fixed_map.get_determinant() - map.get_determinant()) <=
+			FIXED_MATRIX_TOLERANCE * std::abs(map.get_determinant()),
+		name + ": the determinant differs"
+	);
+	check(
+		std::abs(abs(fixed_map) - abs(map)) <=
+			FIXED_MATRIX_TOLERANCE * abs(map),
+		name + ": the norm differs"
+	);
+}
+
+template <size_t... Sizes>
+static void check_fixed_sizes(std::index_sequence<Sizes...>) {
+	(check_fixed_size<Sizes + 1>(), ...);
+}
+
+void check_fixed_matrix() {
+	// Every size that is unrolled and one that keeps its loops
+	check_fixed_sizes(std::make_index_sequence<FIXED_UNROLL_LIMIT>{});
+	check_fixed_size<FIXED_UNROLL_LIMIT + 5>();
+
+	auto singular_map =
+		FixedMatrix<double, 3, 3>::from_matrix(get_singular_matrix());
+	check_throws(
+		[&]() {
+			solve_system_of_equations(
+				singular_map, FixedMatrix<double, 3, 1>::ones()
+			);
+		},
+		"The matrix is singular!",
+		"fixed matrix solve of a singular map"
+	);
+	check(
+		singular_map.get_determinant() == 0,
+		"fixed matrix of a singular map: the determinant is not zero"
+	);
+
+	// Values whose squares overflow or underflow
+	for (const auto &[value, description] :
+		 {std::pair(1e200, "huge"), std::pair(1e-200, "tiny")}) {
+		FixedMatrix<double, 2, 2> matrix({value, value, value, value});
+		check(
+			std::abs(abs(matrix) - 2 * value) <= FIXED_MATRIX_TOLERANCE * value,
+			"fixed matrix norm of " + std::string(description) +
+				" values: the sum of squares is not scaled"
+		);
+	}
+	auto infinite = FixedMatrix<double, 2, 2>::ones();
+	infinite.at(0, 1) = std::numeric_limits<double>::infinity();
+	infinite.at(1, 0) = -std::numeric_limits<double>::infinity();
+	check(
+		std::isinf(abs(infinite)),
+		"fixed matrix norm of infinities: the norm is not infinite"
+	);
+}
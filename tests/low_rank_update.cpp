@@ -0,0 +1,131 @@
+#include "checks.hpp"
+
+#include "../src/core/low_rank_update.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+#include <cmath>
+
+const std::vector<size_t> LOW_RANK_UPDATE_SIZES = {2, 7, 65};
+// The update goes through the capacitance matrix instead of a factorization
+// of the updated matrix, which rounds differently
+constexpr double LOW_RANK_UPDATE_TOLERANCE = 1e-8;
+
+static void check_update(
+	const Matrix<double> &map,
+	const RankUpdate<double> &update,
+	const std::string &name
+) {
+	Matrix<double> updated_map = map + update.u * update.v.get_transpose();
+	auto right_side = Matrix<double>::random(
+		map.get_number_of_rows(), 3, CHECK_MIN, CHECK_MAX, 3
+	);
+	const auto factorization = LuFactorization<double>::factorize(map);
+	LowRankUpdate<double> low_rank_update(map, factorization, update);
+
+	check(
+		get_relative_error(
+			low_rank_update.solve(right_side),
+			solve_system_of_equations(updated_map, right_side)
+		) < LOW_RANK_UPDATE_TOLERANCE,
+		name + ": the solution differs from GEM of the updated map"
+	);
+	const double determinant = updated_map.get_determinant();
+	check(
+		std::abs(low_rank_update.get_determinant() - determinant) <=
+			LOW_RANK_UPDATE_TOLERANCE * std::abs(determinant),
+		name + ": the determinant differs"
+	);
+	auto inverse = updated_map.get_inverse();
+	check(
+		get_relative_error(low_rank_update.get_inverse(), inverse) <
+			LOW_RANK_UPDATE_TOLERANCE,
+		name + ": the inverse differs"
+	);
+	// Updating an inverse needs the inverse of the map to begin with
+	if (!factorization.is_singular()) {
+		check(
+			get_relative_error(
+				update_inverse(map, map.get_inverse(), update), inverse
+			) < LOW_RANK_UPDATE_TOLERANCE,
+			name + ": the updated inverse differs"
+		);
+	}
+}
+
+void check_low_rank_update() {
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : LOW_RANK_UPDATE_SIZES) {
+			const std::string name = "low-rank update of " + test_matrix.name +
+									 " " + std::to_string(size);
+			auto map = test_matrix.generate(size, size);
+			check_update(
+				map,
+				get_row_replacement(
+					map,
+					{0, size - 1},
+					Matrix<double>::random(
+						2, size, CHECK_MIN, CHECK_MAX, size + 1
+					)
+				),
+				name + " replacing two rows"
+			);
+			check_update(
+				map,
+				get_column_replacement(
+					map,
+					{1},
+					Matrix<double>::random(
+						size, 1, CHECK_MIN, CHECK_MAX, size + 2
+					)
+				),
+				name + " replacing a column"
+			);
+		}
+	}
+
+	// A singular map made regular by the update is factorized from scratch
+	auto singular_map = get_singular_matrix();
+	auto update = get_row_replacement(
+		singular_map, {1}, Matrix<double>(std::vector<double>{0, 1, 0}, 1, 3)
+	);
+	LowRankUpdate<double> regular_update(
+		singular_map, LuFactorization<double>::factorize(singular_map), update
+	);
+	check(
+		regular_update.was_refactored(),
+		"low-rank update of a singular map: the map is not refactored"
+	);
+	check_update(singular_map, update, "low-rank update of a singular map");
+
+	// A regular map made singular by the update
+	auto identity = Matrix<double>::identity(3);
+	auto singular_update = get_row_replacement(
+		identity, {2}, Matrix<double>(std::vector<double>{1, 0, 0}, 1, 3)
+	);
+	LowRankUpdate<double> singular_low_rank_update(
+		identity, LuFactorization<double>::factorize(identity), singular_update
+	);
+	check(
+		singular_low_rank_update.was_refactored(),
+		"low-rank update to a singular map: the map is not refactored"
+	);
+	check_throws(
+		[&]() { singular_low_rank_update.solve(Matrix<double>::ones(3, 1)); },
+		"The matrix is singular!",
+		"low-rank update to a singular map"
+	);
+
+	check_throws(
+		[&]() {
+			LowRankUpdate<double>(
+				identity,
+				LuFactorization<double>::factorize(identity),
+				RankUpdate<double>{
+					Matrix<double>::ones(3, 1), Matrix<double>::ones(2, 1)
+				}
+			);
+		},
+		"The update has the wrong size!",
+		"low-rank update of the wrong size"
+	);
+}
@@ -0,0 +1,67 @@
+#include "checks.hpp"
+
+#include <cmath>
+#include <limits>
+
+// Enough rows for every worker of the pool to get a chunk of its own
+constexpr size_t MATRIX_EXPRESSION_SIZE = 131;
+constexpr double MATRIX_EXPRESSION_TOLERANCE = 1e-12;
+
+void check_matrix_expression() {
+	const size_t size = MATRIX_EXPRESSION_SIZE;
+	auto lhs = Matrix<double>::random(size, CHECK_MIN, CHECK_MAX, 1);
+	auto rhs = Matrix<double>::random(size, 2, CHECK_MIN, CHECK_MAX, 2);
+	auto other = Matrix<double>::random(size, 2, CHECK_MIN, CHECK_MAX, 3);
+
+	std::vector<double> expected_values(size * 2, 0);
+	for (size_t row = 0; row < size; ++row) {
+		for (size_t i = 0; i < size; ++i) {
+			for (size_t column = 0; column < 2; ++column) {
+				expected_values[row * 2 + column] +=
+					lhs.at(row, i) * rhs.at(i, column);
+			}
+		}
+	}
+	Matrix<double> expected_product(expected_values, size, 2);
+	Matrix<double> product = lhs * rhs;
+	check(
+		get_relative_error(product, expected_product) <
+			MATRIX_EXPRESSION_TOLERANCE,
+		"matrix expression product: the product differs"
+	);
+
+	Matrix<double> difference = other - lhs * rhs;
+	check(
+		abs(other - lhs * rhs) == abs(difference),
+		"matrix expression norm: the norm of an expression differs from the "
+		"one of its value"
+	);
+
+	// Values whose squares overflow or underflow
+	for (const auto &[value, description] :
+		 {std::pair(1e200, "huge"), std::pair(1e-200, "tiny")}) {
+		Matrix<double> matrix(
+			std::vector<double>(size * size, value), size, size
+		);
+		check(
+			std::abs(abs(matrix) - size * value) <=
+				MATRIX_EXPRESSION_TOLERANCE * size * value,
+			"matrix expression norm of " + std::string(description) +
+				" values: the sum of squares is not scaled"
+		);
+	}
+
+	// Infinities in the chunks of different workers
+	std::vector<double> values(size * size, 1);
+	values.front() = std::numeric_limits<double>::infinity();
+	values.back() = -std::numeric_limits<double>::infinity();
+	check(
+		std::isinf(abs(Matrix<double>(values, size, size))),
+		"matrix expression norm of infinities: the norm is not infinite"
+	);
+	values[size * size / 2] = std::numeric_limits<double>::quiet_NaN();
+	check(
+		std::isnan(abs(Matrix<double>(values, size, size))),
+		"matrix expression norm of a NaN: the norm is not NaN"
+	);
+}
@@ -0,0 +1,89 @@
+#include "checks.hpp"
+
+#include "../src/core/out_of_core_system_of_equations.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+constexpr size_t OUT_OF_CORE_RIGHT_SIDES = 3;
+// Sizes around the blocks of the triangular solve
+const std::vector<size_t> OUT_OF_CORE_SIZES = {1, 2, 7, 64, 65, 131};
+
+// Get the memory limit that leaves room for panels of the given width
+static size_t get_memory_limit(size_t size, size_t panel_width) {
+	return size * (2 * OUT_OF_CORE_RIGHT_SIDES * sizeof(double) +
+				   sizeof(size_t)) +
+		   OUT_OF_CORE_BUFFERS * size * panel_width * sizeof(double);
+}
+
+void check_out_of_core() {
+	TemporaryDirectory directory;
+	const std::string map_file_path = directory.get_path() / "map";
+
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : OUT_OF_CORE_SIZES) {
+			const std::string name = "out-of-core solve of " +
+									 test_matrix.name + " " +
+									 std::to_string(size);
+			auto map = test_matrix.generate(size, size);
+			auto right_side = Matrix<double>::random(
+				size, OUT_OF_CORE_RIGHT_SIDES, CHECK_MIN, CHECK_MAX, size + 1
+			);
+			auto solution = solve_system_of_equations(map, right_side);
+
+			// Both from a binary and a text file, which rounds the values
+			for (bool binary : {true, false}) {
+				map.save_to_file(map_file_path, binary);
+				auto expected_solution =
+					binary ? solution
+						   : solve_system_of_equations(
+								 Matrix<double>::from_file(map_file_path),
+								 right_side
+							 );
+
+				// Panels of two columns, of 64 and all in one
+				for (size_t panel_width : {size_t(2), size_t(64), size}) {
+					check(
+						are_bitwise_identical(
+							solve_system_of_equations_out_of_core(
+								map_file_path,
+								right_side,
+								get_memory_limit(size, panel_width),
+								true,
+								directory.get_path()
+							),
+							expected_solution
+						),
+						name + " in panels of " + std::to_string(panel_width) +
+							(binary ? " from binary" : " from text") +
+							": the solution differs from GEM"
+					);
+				}
+			}
+		}
+	}
+
+	get_singular_matrix().save_to_file(map_file_path, true);
+	auto solve_singular = [&](size_t size, size_t memory_limit) {
+		solve_system_of_equations_out_of_core(
+			map_file_path,
+			Matrix<double>::ones(size, OUT_OF_CORE_RIGHT_SIDES),
+			memory_limit,
+			true,
+			directory.get_path()
+		);
+	};
+	check_throws(
+		[&]() { solve_singular(3, get_memory_limit(3, 2)); },
+		"The matrix is singular!",
+		"out-of-core solve of a singular map"
+	);
+	check_throws(
+		[&]() { solve_singular(3, get_memory_limit(3, 0)); },
+		"The memory limit is too small!",
+		"out-of-core solve without room for a panel"
+	);
+	check_throws(
+		[&]() { solve_singular(4, get_memory_limit(4, 2)); },
+		"The matrix does not match the right side!",
+		"out-of-core solve with a right side of another size"
+	);
+}
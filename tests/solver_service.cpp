@@ -0,0 +1,323 @@
+#include "checks.hpp"
+
+#include "../src/core/solver_service.hpp"
+
+#include <thread>
+
+#include <unistd.h>
+
+constexpr double SERVICE_TOLERANCE = 1e-9;
+
+// A response as it arrived. The values are not kept in a matrix, since one
+// made while the executor runs would come from the arena of the service.
+struct ServiceResponse {
+	ServiceResponseHeader header;
+	std::vector<double> values;
+	std::string error;
+
+	bool is_ok() const {
+		return this->header.status == static_cast<uint32_t>(ServiceStatus::Ok);
+	}
+
+	Matrix<double> get_result() const {
+		return Matrix<double>(
+			this->values,
+			this->header.number_of_rows,
+			this->header.number_of_columns
+		);
+	}
+};
+
+// Builds a stream of requests as a client sends it
+class ServiceRequestStream {
+	private:
+	std::vector<char> bytes;
+
+	void append(const void *data, size_t size) {
+		const char *source = static_cast<const char *>(data);
+		this->bytes.insert(this->bytes.end(), source, source + size);
+	}
+
+	void append(const Matrix<double> &matrix) {
+		for (size_t row = 0; row < matrix.get_number_of_rows(); ++row) {
+			for (size_t column = 0; column < matrix.get_number_of_columns();
+				 ++column) {
+				this->append(&matrix.at(row, column), sizeof(double));
+			}
+		}
+	}
+
+	public:
+	void add_header(const ServiceRequestHeader &header) {
+		this->append(&header, sizeof(header));
+	}
+
+	void add(
+		ServiceOperation operation,
+		uint64_t id,
+		const Matrix<double> &map,
+		const std::optional<Matrix<double>> &right_side = std::nullopt
+	) {
+		this->add_header(
+			{SERVICE_REQUEST_MAGIC,
+			 static_cast<uint32_t>(operation),
+			 id,
+			 map.get_number_of_rows(),
+			 map.get_number_of_columns(),
+			 right_side.has_value() ? right_side->get_number_of_columns() : 0}
+		);
+		this->append(map);
+		if (right_side.has_value()) {
+			this->append(*right_side);
+		}
+	}
+
+	const std::vector<char> &get_bytes() const { return this->bytes; }
+};
+
+// Serves the requests on a single connection until they run out and returns
+// the responses in the order they were sent
+static std::vector<ServiceResponse>
+exchange(const ServiceRequestStream &requests) {
+	int request_pipe[2];
+	int response_pipe[2];
+	if (pipe(request_pipe) == -1 || pipe(response_pipe) == -1) {
+		throw std::runtime_error("Could not create a pipe!");
+	}
+
+	std::thread client([&]() {
+		write_exactly(
+			request_pipe[1],
+			requests.get_bytes().data(),
+			requests.get_bytes().size()
+		);
+		close(request_pipe[1]);
+	});
+
+	std::vector<ServiceResponse> responses;
+	std::thread receiver([&]() {
+		ServiceResponse response;
+		while (read_exactly(
+			response_pipe[0], &response.header, sizeof(response.header)
+		)) {
+			if (response.is_ok()) {
+				response.values.resize(
+					response.header.number_of_rows *
+					response.header.number_of_columns
+				);
+				read_exactly(
+					response_pipe[0],
+					response.values.data(),
+					response.values.size() * sizeof(double)
+				);
+			} else {
+				response.error.resize(response.header.number_of_rows);
+				read_exactly(
+					response_pipe[0],
+					response.error.data(),
+					response.error.size()
+				);
+			}
+			responses.push_back(response);
+			response = ServiceResponse();
+		}
+	});
+
+	{
+		SolverService<double> service;
+		std::atomic<bool> stopping{false};
+		std::thread reader = service.start_reader(
+			std::make_shared<ServiceConnection>(
+				request_pipe[0], response_pipe[1], false
+			)
+		);
+		service.run(stopping, true);
+		reader.join();
+	}
+
+	client.join();
+	close(response_pipe[1]);
+	receiver.join();
+	close(request_pipe[0]);
+	close(response_pipe[0]);
+	return responses;
+}
+
+static const ServiceResponse *
+find_response(const std::vector<ServiceResponse> &responses, uint64_t id) {
+	for (const auto &response : responses) {
+		if (response.header.id == id) {
+			return &response;
+		}
+	}
+	return nullptr;
+}
+
+static void check_result(
+	const std::vector<ServiceResponse> &responses,
+	uint64_t id,
+	const Matrix<double> &expected,
+	const std::string &description
+) {
+	const ServiceResponse *response = find_response(responses, id);
+	check(
+		response != nullptr && response->is_ok() &&
+			response->header.number_of_rows == expected.get_number_of_rows() &&
+			response->header.number_of_columns ==
+				expected.get_number_of_columns() &&
+			get_relative_error(response->get_result(), expected) <
+				SERVICE_TOLERANCE,
+		"service: " + description + " is not answered with the result"
+	);
+}
+
+static void check_error(
+	const std::vector<ServiceResponse> &responses,
+	uint64_t id,
+	const std::string &message,
+	const std::string &description
+) {
+	const ServiceResponse *response = find_response(responses, id);
+	check(
+		response != nullptr && !response->is_ok() &&
+			response->error == message,
+		"service: " + description + " is not answered with \"" + message +
+			"\""
+	);
+}
+
+void check_solver_service() {
+	auto map = Matrix<double>::random(5, CHECK_MIN, CHECK_MAX, 1);
+	auto right_side = Matrix<double>::random(5, 1, CHECK_MIN, CHECK_MAX, 2);
+	auto right_sides = Matrix<double>::random(5, 2, CHECK_MIN, CHECK_MAX, 3);
+	auto singular_map = get_singular_matrix();
+	auto large_map = Matrix<double>::random(
+		SERVICE_BATCH_SIZE_LIMIT + 1, CHECK_MIN, CHECK_MAX, 4
+	);
+	auto large_right_side = Matrix<double>::random(
+		SERVICE_BATCH_SIZE_LIMIT + 1, 1, CHECK_MIN, CHECK_MAX, 5
+	);
+
+	ServiceRequestStream requests;
+	// Batched, on their own, and too large to be batched
+	requests.add(ServiceOperation::Solve, 1, map, right_side);
+	requests.add(ServiceOperation::Solve, 2, map, right_sides);
+	requests.add(ServiceOperation::Solve, 3, large_map, large_right_side);
+	// A singular map fails the same way whether it is batched or not
+	requests.add(
+		ServiceOperation::Solve, 4, singular_map, Matrix<double>::ones(3, 1)
+	);
+	requests.add(
+		ServiceOperation::Solve, 5, singular_map, Matrix<double>::ones(3, 2)
+	);
+	requests.add(ServiceOperation::Invert, 6, map);
+	requests.add(ServiceOperation::Determinant, 7, map);
+	requests.add(
+		ServiceOperation::Solve,
+		8,
+		Matrix<double>::random(5, 4, CHECK_MIN, CHECK_MAX, 6),
+		right_side
+	);
+	auto responses = exchange(requests);
+
+	check(responses.size() == 8, "service: not every request is answered");
+	for (const auto &response : responses) {
+		check(
+			response.header.magic == SERVICE_RESPONSE_MAGIC,
+			"service: a response has the wrong magic"
+		);
+	}
+	check_result(
+		responses,
+		1,
+		solve_system_of_equations(map, right_side),
+		"a batched solve"
+	);
+	check_result(
+		responses,
+		2,
+		solve_system_of_equations(map, right_sides),
+		"a solve with two right sides"
+	);
+	check_result(
+		responses,
+		3,
+		solve_system_of_equations(large_map, large_right_side),
+		"a solve too large for batching"
+	);
+	check_error(
+		responses, 4, "The matrix is singular!", "a batched singular solve"
+	);
+	check_error(
+		responses,
+		5,
+		"The matrix is singular!",
+		"a singular solve with two right sides"
+	);
+	check_result(responses, 6, map.get_inverse(), "an inversion");
+	check_result(
+		responses,
+		7,
+		Matrix<double>(std::vector<double>{map.get_determinant()}, 1, 1),
+		"a determinant"
+	);
+	check_error(
+		responses,
+		8,
+		"Cannot solve a system of equations with a non-square matrix!",
+		"a solve with a non-square map"
+	);
+
+	// The statistics cover the requests answered before them
+	ServiceRequestStream statistics_requests;
+	statistics_requests.add(ServiceOperation::Determinant, 1, map);
+	statistics_requests.add(
+		ServiceOperation::Statistics, 2, Matrix<double>::ones(0, 0)
+	);
+	auto statistics_responses = exchange(statistics_requests);
+	const ServiceResponse *statistics = find_response(statistics_responses, 2);
+	check(
+		statistics != nullptr && statistics->is_ok() &&
+			statistics->values.size() == 5 && statistics->values[0] >= 1,
+		"service: the statistics do not count the answered requests"
+	);
+
+	// A malformed request is answered with an error and the rest of the
+	// connection is dropped
+	ServiceRequestStream malformed_requests;
+	malformed_requests.add_header({0, 0, 1, 1, 1, 1});
+	malformed_requests.add(ServiceOperation::Determinant, 2, map);
+	auto malformed_responses = exchange(malformed_requests);
+	check(
+		malformed_responses.size() == 1,
+		"service: a malformed request does not drop the connection"
+	);
+	check_error(
+		malformed_responses, 1, "Malformed request!", "a malformed request"
+	);
+
+	ServiceRequestStream unknown_requests;
+	unknown_requests.add_header({SERVICE_REQUEST_MAGIC, 42, 1, 1, 1, 0});
+	check_error(
+		exchange(unknown_requests),
+		1,
+		"Unknown operation!",
+		"an unknown operation"
+	);
+
+	ServiceRequestStream oversized_requests;
+	oversized_requests.add_header(
+		{SERVICE_REQUEST_MAGIC,
+		 static_cast<uint32_t>(ServiceOperation::Solve),
+		 1,
+		 uint64_t(1) << 32,
+		 uint64_t(1) << 32,
+		 1}
+	);
+	check_error(
+		exchange(oversized_requests),
+		1,
+		"The matrix of the request is too large!",
+		"an oversized request"
+	);
+}
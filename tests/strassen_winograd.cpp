@@ -0,0 +1,69 @@
+#include "checks.hpp"
+
+#include "../src/core/strassen_winograd.hpp"
+
+#include <tuple>
+
+// Strassen-Winograd adds and subtracts blocks before multiplying them, which
+// rounds differently from the classical product
+constexpr double STRASSEN_WINOGRAD_TOLERANCE = 1e-12;
+
+// Shapes below the cutoff, of one and two levels, odd ones that get padded
+// and rectangular ones
+const std::vector<std::tuple<size_t, size_t, size_t>> STRASSEN_WINOGRAD_SHAPES =
+	{{1, 1, 1},
+	 {64, 64, 64},
+	 {128, 128, 128},
+	 {129, 130, 131},
+	 {256, 256, 256},
+	 {300, 260, 513},
+	 {513, 140, 129}};
+
+void check_strassen_winograd() {
+	for (const auto &[m, k, n] : STRASSEN_WINOGRAD_SHAPES) {
+		const std::string name = "Strassen-Winograd product of " +
+								 std::to_string(m) + "x" + std::to_string(k) +
+								 " and " + std::to_string(k) + "x" +
+								 std::to_string(n);
+		auto lhs = Matrix<double>::random(m, k, CHECK_MIN, CHECK_MAX, m);
+		auto rhs = Matrix<double>::random(k, n, CHECK_MIN, CHECK_MAX, n + 1);
+		auto product = lhs * rhs;
+
+		check(
+			are_bitwise_identical(
+				multiply(lhs, rhs, MultiplicationMethod::Classical), product
+			),
+			name + ": the classical product differs"
+		);
+		auto strassen_winograd_product =
+			multiply(lhs, rhs, MultiplicationMethod::StrassenWinograd);
+		check(
+			strassen_winograd_product.get_number_of_rows() == m &&
+				strassen_winograd_product.get_number_of_columns() == n &&
+				get_relative_error(strassen_winograd_product, product) <
+					STRASSEN_WINOGRAD_TOLERANCE,
+			name + ": the product differs from the classical one"
+		);
+		check(
+			are_bitwise_identical(
+				multiply(
+					lhs, rhs, MultiplicationMethod::StrassenWinograd, false
+				),
+				strassen_winograd_product
+			),
+			name + ": the sequential product differs"
+		);
+	}
+
+	check_throws(
+		[]() {
+			multiply(
+				Matrix<double>::ones(2, 3),
+				Matrix<double>::ones(2, 3),
+				MultiplicationMethod::StrassenWinograd
+			);
+		},
+		"Cannot multiply matrices of these sizes!",
+		"Strassen-Winograd product of mismatched sizes"
+	);
+}
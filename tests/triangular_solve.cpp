@@ -0,0 +1,93 @@
+#include "checks.hpp"
+
+#include "../src/core/lu_factorization.hpp"
+#include "../src/core/system_of_equations.hpp"
+
+// Numbers of right sides below, at and above a cache line of values
+const std::vector<size_t> TRIANGULAR_SOLVE_RIGHT_SIDES = {1, 3, 8, 17};
+// Sizes around the blocks of the triangular solve
+const std::vector<size_t> TRIANGULAR_SOLVE_SIZES = {1, 2, 7, 64, 65, 131};
+constexpr double JORDAN_TOLERANCE = 1e-8;
+
+static Matrix<double> get_column(const Matrix<double> &matrix, size_t column) {
+	std::vector<double> values;
+	for (size_t row = 0; row < matrix.get_number_of_rows(); ++row) {
+		values.push_back(matrix.at(row, column));
+	}
+	return Matrix<double>(values, values.size(), 1);
+}
+
+void check_triangular_solve() {
+	for (const auto &test_matrix : get_test_matrices()) {
+		for (size_t size : TRIANGULAR_SOLVE_SIZES) {
+			for (size_t number_of_right_sides : TRIANGULAR_SOLVE_RIGHT_SIDES) {
+				const std::string name = "triangular solve of " +
+										 test_matrix.name + " " +
+										 std::to_string(size) + " with " +
+										 std::to_string(number_of_right_sides);
+				auto map = test_matrix.generate(size, size);
+				auto right_side = Matrix<double>::random(
+					size, number_of_right_sides, CHECK_MIN, CHECK_MAX, size + 1
+				);
+
+				auto solution = solve_system_of_equations(map, right_side, true);
+				check(
+					are_bitwise_identical(
+						solution,
+						solve_system_of_equations(map, right_side, false)
+					),
+					name + ": the sequential solution differs"
+				);
+				check(
+					are_bitwise_identical(
+						solution,
+						LuFactorization<double>::factorize(map).solve(right_side)
+					),
+					name + ": the LU solution differs"
+				);
+
+				// The workers split the right sides, which must not change
+				// any of their solutions
+				const size_t last = number_of_right_sides - 1;
+				check(
+					are_bitwise_identical(
+						get_column(solution, last),
+						solve_system_of_equations(
+							map, get_column(right_side, last)
+						)
+					),
+					name + ": the last right side solved alone differs"
+				);
+
+				check(
+					get_relative_error(
+						solve_system_of_equations(
+							map,
+							right_side,
+							true,
+							BackSubstitutionMethod::Jordan
+						),
+						solution
+					) < JORDAN_TOLERANCE,
+					name + ": the JEM solution differs"
+				);
+			}
+		}
+	}
+
+	for (auto method :
+		 {BackSubstitutionMethod::Triangular, BackSubstitutionMethod::Jordan}) {
+		check_throws(
+			[method]() {
+				solve_system_of_equations(
+					get_singular_matrix(),
+					Matrix<double>::ones(3, 1),
+					true,
+					method
+				);
+			},
+			"The matrix is singular!",
+			"triangular solve of a singular map"
+		);
+	}
+}